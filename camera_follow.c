@@ -0,0 +1,95 @@
+/**
+ * @file        camera_follow.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Eased, dead-zoned viewport follow.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "camera_follow.h"
+#include <math.h>
+
+/**
+ * @brief Top left that centres a point, kept inside the map.
+ */
+static double centreOn(double point, double view, double map) {
+  double origin = point - view / 2;
+  double max = map > view ? map - view : 0;
+  if (origin > max) origin = max;
+  if (origin < 0) origin = 0;
+  return origin;
+}
+
+/**
+ * @brief True if a point is within the central CAMERA_DEAD_ZONE of a view axis.
+ */
+static bool inDeadZone(double point, double origin, double view) {
+  return fabs(point - (origin + view / 2)) <= view * CAMERA_DEAD_ZONE / 2;
+}
+
+void cameraReset(followCamera *cam, double x, double y) {
+  cam->placed = true;
+  cam->moving = false;
+  cam->x = cam->targetX = x;
+  cam->y = cam->targetY = y;
+}
+
+bool cameraFollow(followCamera *cam, double markerX, double markerY, double viewWidth, double viewHeight,
+                  double mapWidth, double mapHeight, int64_t nowUs) {
+  if (cam->placed && inDeadZone(markerX, cam->targetX, viewWidth) && inDeadZone(markerY, cam->targetY, viewHeight)) {
+    return cam->moving;
+  }
+  double targetX = centreOn(markerX, viewWidth, mapWidth);
+  double targetY = centreOn(markerY, viewHeight, mapHeight);
+  if (!cam->placed) {
+    cameraReset(cam, targetX, targetY);
+    return false;
+  }
+  // At a map edge the marker can stay outside the zone with nowhere to go
+  if (targetX == cam->targetX && targetY == cam->targetY) return cam->moving;
+
+  cam->targetX = targetX;
+  cam->targetY = targetY;
+  if (!cam->moving) cam->stepUs = nowUs;
+  cam->moving = true;
+  return true;
+}
+
+bool cameraStep(followCamera *cam, int64_t nowUs) {
+  if (!cam->moving) return false;
+  int64_t elapsedUs = nowUs - cam->stepUs;
+  cam->stepUs = nowUs;
+  if (elapsedUs <= 0) return true;
+
+  // Exponential ease, independent of the frame rate
+  double k = 1.0 - exp(-elapsedUs / (CAMERA_EASE_MS * 1000.0));
+  cam->x += (cam->targetX - cam->x) * k;
+  cam->y += (cam->targetY - cam->y) * k;
+  if (fabs(cam->targetX - cam->x) < CAMERA_SNAP_PX && fabs(cam->targetY - cam->y) < CAMERA_SNAP_PX) {
+    cam->x = cam->targetX;
+    cam->y = cam->targetY;
+    cam->moving = false;
+  }
+  return cam->moving;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file        camera_follow.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Eased viewport that follows the marker with a dead zone.
+ *
+ * @details     The marker may roam the central CAMERA_DEAD_ZONE of the view without the
+ *              view moving. Once it leaves that region the camera is re-aimed to centre it
+ *              again, and the view eases there on the display's frame clock with time
+ *              constant CAMERA_EASE_MS instead of jumping. The view therefore scrolls in
+ *              short, smooth bursts rather than on every fix, and far fewer pixels come
+ *              into view per second.
+ *
+ *              Positions are the view's top left in map widget pixels. Times are monotonic
+ *              microseconds (g_get_monotonic_time / frame clock).
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef CAMERA_FOLLOW_H
+#define CAMERA_FOLLOW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Central fraction of the view (per axis) the marker may move in without scrolling
+#define CAMERA_DEAD_ZONE 0.5
+// Time constant of the ease towards the target (about 95% of the way after three)
+#define CAMERA_EASE_MS 200
+// Closer than this the camera lands on its target
+#define CAMERA_SNAP_PX 0.5
+
+/**
+ * @brief Camera state for one scrolling view.
+ */
+typedef struct followCamera {
+  bool placed;            // false until the first target, which is jumped to
+  bool moving;
+  double x;               // view top left now
+  double y;
+  double targetX;         // view top left being eased to
+  double targetY;
+  int64_t stepUs;         // time of the last step
+} followCamera;
+
+/**
+ * @brief Stops the camera at a view position, e.g. after the user scrolled or zoomed.
+ */
+void cameraReset(followCamera *cam, double x, double y);
+
+/**
+ * @brief Re-aims the camera if the marker has left the dead zone.
+ *
+ * The dead zone is taken around the view the camera is heading for, so a
+ * moving marker does not re-aim it every frame. Targets are clamped to the map.
+ *
+ * @param cam Camera state
+ * @param markerX Marker position in map widget pixels
+ * @param markerY Marker position in map widget pixels
+ * @param viewWidth View size in pixels
+ * @param viewHeight View size in pixels
+ * @param mapWidth Scrollable map size in pixels
+ * @param mapHeight Scrollable map size in pixels
+ * @param nowUs Current time
+ * @return bool True if the camera is easing and needs cameraStep every frame
+ */
+bool cameraFollow(followCamera *cam, double markerX, double markerY, double viewWidth, double viewHeight,
+                  double mapWidth, double mapHeight, int64_t nowUs);
+
+/**
+ * @brief Advances the camera to nowUs.
+ *
+ * @return bool True while the camera is still easing
+ */
+bool cameraStep(followCamera *cam, int64_t nowUs);
+
+#endif
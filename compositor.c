@@ -0,0 +1,214 @@
+/**
+ * @file        compositor.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Cached map view layers with per-layer dirty regions.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "compositor.h"
+#include <stddef.h>
+
+/**
+ * @brief One cached layer.
+ */
+typedef struct compositorLayer {
+  compositorPaintFunc paint;
+  void *data;
+  cairo_format_t format;
+  bool scrolls;
+  bool visible;
+  cairo_rectangle_int_t bounds;   // map widget coordinates
+  cairo_surface_t *surface;       // bounds-sized, NULL until first painted
+  cairo_surface_t *spare;         // same size, target of the next scroll copy
+  cairo_region_t *dirty;          // map widget coordinates, within bounds
+} compositorLayer;
+
+static compositorLayer layers[LAYER_COUNT];
+
+/**
+ * @brief Drops the layer's surfaces, so the next frame repaints it whole at its new size.
+ */
+static void dropSurfaces(compositorLayer *layer) {
+  if (layer->surface) cairo_surface_destroy(layer->surface);
+  if (layer->spare) cairo_surface_destroy(layer->spare);
+  layer->surface = NULL;
+  layer->spare = NULL;
+}
+
+/**
+ * @brief Marks the layer's whole box dirty.
+ */
+static void markAll(compositorLayer *layer) {
+  if (layer->dirty) cairo_region_destroy(layer->dirty);
+  layer->dirty = cairo_region_create_rectangle(&layer->bounds);
+}
+
+/**
+ * @brief Moves the kept pixels of a scrolling layer to its new box.
+ *
+ * The copy goes through a spare surface, as cairo does not support
+ * overlapping copies within one surface.
+ *
+ * @return bool False if nothing could be kept
+ */
+static bool scrollPixels(compositorLayer *layer, const cairo_rectangle_int_t *old) {
+  if (!layer->spare) {
+    layer->spare = cairo_image_surface_create(layer->format, layer->bounds.width, layer->bounds.height);
+    if (cairo_surface_status(layer->spare) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(layer->spare);
+      layer->spare = NULL;
+      return false;
+    }
+  }
+  cairo_t *cr = cairo_create(layer->spare);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr, layer->surface, old->x - layer->bounds.x, old->y - layer->bounds.y);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+
+  cairo_surface_t *swap = layer->surface;
+  layer->surface = layer->spare;
+  layer->spare = swap;
+
+  // Earlier damage that is still inside, plus what came into view
+  cairo_region_t *exposed = cairo_region_create_rectangle(&layer->bounds);
+  cairo_region_subtract_rectangle(exposed, old);
+  cairo_region_union(layer->dirty, exposed);
+  cairo_region_intersect_rectangle(layer->dirty, &layer->bounds);
+  cairo_region_destroy(exposed);
+  return true;
+}
+
+/**
+ * @brief Repaints the dirty part of a layer, creating its surface first if needed.
+ *
+ * @return bool False if the layer has no surface to composite
+ */
+static bool repaintLayer(compositorLayer *layer) {
+  if (!layer->surface) {
+    layer->surface = cairo_image_surface_create(layer->format, layer->bounds.width, layer->bounds.height);
+    if (cairo_surface_status(layer->surface) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(layer->surface);
+      layer->surface = NULL;
+      return false;
+    }
+    markAll(layer);
+  }
+  if (cairo_region_is_empty(layer->dirty)) return true;
+
+  cairo_t *cr = cairo_create(layer->surface);
+  cairo_translate(cr, -layer->bounds.x, -layer->bounds.y);
+  int count = cairo_region_num_rectangles(layer->dirty);
+  for (int i = 0; i < count; i++) {
+    cairo_rectangle_int_t rect;
+    cairo_region_get_rectangle(layer->dirty, i, &rect);
+    cairo_rectangle(cr, rect.x, rect.y, rect.width, rect.height);
+  }
+  cairo_clip(cr);
+  if (layer->format == CAIRO_FORMAT_ARGB32) {
+    cairo_save(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_restore(cr);
+  }
+  layer->paint(cr, layer->data);
+  cairo_destroy(cr);
+
+  cairo_region_destroy(layer->dirty);
+  layer->dirty = cairo_region_create();
+  return true;
+}
+
+void compositorInitLayer(compositorLayerId id, cairo_format_t format, bool scrolls,
+                         compositorPaintFunc paint, void *data) {
+  compositorLayer *layer = &layers[id];
+  dropSurfaces(layer);
+  layer->paint = paint;
+  layer->data = data;
+  layer->format = format;
+  layer->scrolls = scrolls;
+  layer->visible = false;
+  layer->bounds = (cairo_rectangle_int_t){0, 0, 0, 0};
+  markAll(layer);
+}
+
+void compositorPlace(compositorLayerId id, const cairo_rectangle_int_t *bounds) {
+  compositorLayer *layer = &layers[id];
+  cairo_rectangle_int_t old = layer->bounds;
+  if (old.x == bounds->x && old.y == bounds->y && old.width == bounds->width && old.height == bounds->height) return;
+  layer->bounds = *bounds;
+
+  if (old.width != bounds->width || old.height != bounds->height) {
+    dropSurfaces(layer);
+    markAll(layer);
+    return;
+  }
+  bool overlaps = old.x < bounds->x + bounds->width && bounds->x < old.x + old.width &&
+                  old.y < bounds->y + bounds->height && bounds->y < old.y + old.height;
+  if (!layer->scrolls || !layer->surface || !overlaps || !scrollPixels(layer, &old)) markAll(layer);
+}
+
+void compositorSetVisible(compositorLayerId id, bool visible) {
+  layers[id].visible = visible;
+}
+
+void compositorDamage(compositorLayerId id, const cairo_rectangle_int_t *rect) {
+  compositorLayer *layer = &layers[id];
+  if (!rect || !layer->dirty) {
+    markAll(layer);
+    return;
+  }
+  cairo_region_union_rectangle(layer->dirty, rect);
+  cairo_region_intersect_rectangle(layer->dirty, &layer->bounds);
+}
+
+void compositorDamageAll() {
+  for (int i = 0; i < LAYER_COUNT; i++) markAll(&layers[i]);
+}
+
+void compositorPaint(cairo_t *cr) {
+  for (int i = 0; i < LAYER_COUNT; i++) {
+    compositorLayer *layer = &layers[i];
+    if (!layer->visible || !layer->paint || layer->bounds.width <= 0 || layer->bounds.height <= 0) continue;
+    if (!repaintLayer(layer)) continue;
+
+    // Opaque layers blend as a plain copy
+    cairo_save(cr);
+    cairo_set_source_surface(cr, layer->surface, layer->bounds.x, layer->bounds.y);
+    cairo_rectangle(cr, layer->bounds.x, layer->bounds.y, layer->bounds.width, layer->bounds.height);
+    cairo_fill(cr);
+    cairo_restore(cr);
+  }
+}
+
+void compositorShutdown() {
+  for (int i = 0; i < LAYER_COUNT; i++) {
+    dropSurfaces(&layers[i]);
+    if (layers[i].dirty) cairo_region_destroy(layers[i].dirty);
+    layers[i].dirty = NULL;
+    layers[i].paint = NULL;
+    layers[i].visible = false;
+  }
+}
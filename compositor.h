@@ -0,0 +1,114 @@
+/**
+ * @file        compositor.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Map view built from separately cached layers (map, track, marker, HUD).
+ *
+ * @details     Each layer keeps its own image surface covering a box in map widget
+ *              coordinates, and a dirty region. Drawing a frame first repaints only the
+ *              dirty parts of each layer through its paint function, then blends the layer
+ *              surfaces bottom to top inside the clip. A marker move therefore repaints the
+ *              marker sprite and recomposites two small boxes, and a HUD refresh never
+ *              touches the map or track.
+ *
+ *              Scrolling layers (map, track) keep the pixels still inside their box when
+ *              they are moved, so scrolling repaints only the strip that came into view.
+ *              Sprite layers (marker, HUD) are repainted whole when moved.
+ *
+ *              Used from the GTK thread (or the offscreen loop) only.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdbool.h>
+#include <cairo.h>
+
+/**
+ * @brief Layers, bottom to top.
+ */
+typedef enum compositorLayerId {
+  LAYER_MAP,
+  LAYER_TRACK,
+  LAYER_MARKER,
+  LAYER_HUD,
+  LAYER_COUNT
+} compositorLayerId;
+
+/**
+ * @brief Paints a layer's content.
+ *
+ * @param cr Context in map widget coordinates, clipped to the dirty area. Layers
+ *           with alpha have had that area cleared.
+ */
+typedef void (*compositorPaintFunc)(cairo_t *cr, void *data);
+
+/**
+ * @brief Sets up a layer. It starts hidden with an empty box.
+ *
+ * @param id Layer to set up
+ * @param format CAIRO_FORMAT_RGB24 for an opaque layer, CAIRO_FORMAT_ARGB32 otherwise
+ * @param scrolls True if moving the box keeps the pixels still inside it
+ * @param paint Paints the layer's content
+ * @param data Passed to paint
+ */
+void compositorInitLayer(compositorLayerId id, cairo_format_t format, bool scrolls,
+                         compositorPaintFunc paint, void *data);
+
+/**
+ * @brief Moves or resizes a layer's box (map widget coordinates). A no-op if unchanged.
+ */
+void compositorPlace(compositorLayerId id, const cairo_rectangle_int_t *bounds);
+
+/**
+ * @brief Shows or hides a layer. Hidden layers keep their cached pixels.
+ */
+void compositorSetVisible(compositorLayerId id, bool visible);
+
+/**
+ * @brief Marks part of a layer for repainting on the next frame.
+ *
+ * @param rect Area in map widget coordinates, or NULL for the whole layer
+ */
+void compositorDamage(compositorLayerId id, const cairo_rectangle_int_t *rect);
+
+/**
+ * @brief Marks every layer for repainting.
+ */
+void compositorDamageAll();
+
+/**
+ * @brief Repaints the dirty parts of the visible layers and blends them inside the clip.
+ *
+ * @param cr Context in map widget coordinates
+ */
+void compositorPaint(cairo_t *cr);
+
+/**
+ * @brief Frees the layer surfaces and regions. Layers must be set up again after this.
+ */
+void compositorShutdown();
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file        dashboard_model.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Formatted dashboard values with per-field change tracking.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "dashboard_model.h"
+#include <stdio.h>
+
+/**
+ * @brief Records a field's new raw value.
+ *
+ * @return bool True if the text needs formatting
+ */
+static bool fieldChanged(dashboardField *field, int32_t value) {
+  if (field->valid && field->value == value) return false;
+  field->value = value;
+  field->valid = true;
+  field->dirty = true;
+  return true;
+}
+
+void dashboardUpdate(dashboardModel *model, const navpvt_data *pvt, int utcOffset) {
+  int hour = (pvt->hour + utcOffset) % 24;
+  if (hour < 0) hour += 24;
+  dashboardField *time = &model->fields[DASHBOARD_TIME];
+  if (fieldChanged(time, hour * 3600 + pvt->min * 60 + pvt->sec)) {
+    snprintf(time->text, sizeof(time->text), "%02d:%02d:%02d", hour, pvt->min, pvt->sec);
+  }
+
+  // gSpeed is mm/s; 447 mm/s is 1 mph
+  int speedMph = (int)(pvt->gSpeed / 447.0f + 0.5f);
+  if (speedMph < DASHBOARD_MIN_SPEED_MPH) speedMph = 0;
+  dashboardField *speed = &model->fields[DASHBOARD_SPEED];
+  if (fieldChanged(speed, speedMph)) {
+    snprintf(speed->text, sizeof(speed->text), "Speed: %d", speedMph);
+  }
+}
+
+const char *dashboardTakeDirty(dashboardModel *model, dashboardFieldId id) {
+  dashboardField *field = &model->fields[id];
+  if (!field->dirty) return NULL;
+  field->dirty = false;
+  return field->text;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file        dashboard_model.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Formatted dashboard values with per-field change tracking.
+ *
+ * @details     Each fix is reduced to the raw values the dashboard actually shows (local
+ *              time to the second, rounded speed). A field is formatted into its fixed
+ *              buffer only when its raw value changes, and marked dirty so the GUI pushes
+ *              just that text to its label. An unchanged value costs one integer compare
+ *              instead of a sprintf, a label update and a relayout.
+ *
+ *              Used from the GTK thread only.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef DASHBOARD_MODEL_H
+#define DASHBOARD_MODEL_H
+
+#include "gps_setup.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Longest formatted field, including the terminator
+#define DASHBOARD_TEXT_LEN 32
+// Speeds below this are shown as 0 (receiver velocity noise when parked)
+#define DASHBOARD_MIN_SPEED_MPH 3
+
+/**
+ * @brief Dashboard fields backed by a label.
+ */
+typedef enum dashboardFieldId {
+  DASHBOARD_TIME,
+  DASHBOARD_SPEED,
+  DASHBOARD_FIELD_COUNT
+} dashboardFieldId;
+
+/**
+ * @brief One formatted value.
+ */
+typedef struct dashboardField {
+  int32_t value;                    // raw value the text was formatted from
+  bool valid;                       // text has been formatted at least once
+  bool dirty;                       // text changed since it was last taken
+  char text[DASHBOARD_TEXT_LEN];
+} dashboardField;
+
+/**
+ * @brief View-model of the dashboard labels.
+ */
+typedef struct dashboardModel {
+  dashboardField fields[DASHBOARD_FIELD_COUNT];
+} dashboardModel;
+
+/**
+ * @brief Reformats the fields whose values changed with this fix.
+ *
+ * @param model Dashboard state
+ * @param pvt Latest NAV-PVT solution
+ * @param utcOffset Hours added to UTC for the displayed time
+ */
+void dashboardUpdate(dashboardModel *model, const navpvt_data *pvt, int utcOffset);
+
+/**
+ * @brief Returns a field's text if it changed since the last call, and clears its dirty flag.
+ *
+ * @return const char* Text to push to the widget, or NULL if nothing changed
+ */
+const char *dashboardTakeDirty(dashboardModel *model, dashboardFieldId id);
+
+#endif
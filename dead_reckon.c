@@ -0,0 +1,130 @@
+/**
+ * @file        dead_reckon.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Extrapolates the displayed position between receiver fixes.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "dead_reckon.h"
+#include <math.h>
+
+// Metres per degree of latitude (mean, WGS84)
+#define METRES_PER_DEGREE 111319.49
+// Larger differences at a new fix are a reacquisition and snap instead of blending
+#define DEAD_RECKON_SNAP_M 150.0
+
+/**
+ * @brief Extrapolated position of the fix itself, without blending.
+ */
+static void extrapolate(const deadReckoner *dr, int64_t nowUs, double *latE7, double *lonE7) {
+  *latE7 = dr->fix.latE7;
+  *lonE7 = dr->fix.lonE7;
+  int64_t ageUs = nowUs - dr->fixUs;
+  if (ageUs <= 0) return;
+  if (ageUs > DEAD_RECKON_MAX_GAP_MS * 1000) ageUs = DEAD_RECKON_MAX_GAP_MS * 1000;
+
+  double speed = hypot(dr->velN, dr->velE);
+  if (speed < DEAD_RECKON_MIN_SPEED_MM_S) return;
+
+  double seconds = ageUs / 1e6;
+  double northM = dr->velN / 1000.0 * seconds;
+  double eastM = dr->velE / 1000.0 * seconds;
+  double cosLat = cos(dr->fix.latE7 / 1e7 * M_PI / 180.0);
+  *latE7 += northM / METRES_PER_DEGREE * 1e7;
+  if (cosLat > 1e-6) *lonE7 += eastM / (METRES_PER_DEGREE * cosLat) * 1e7;
+}
+
+/**
+ * @brief Fraction of the arrival offset still applied at nowUs (1 -> 0).
+ */
+static double blendRemaining(const deadReckoner *dr, int64_t nowUs) {
+  int64_t ageUs = nowUs - dr->arrivedUs;
+  if (ageUs <= 0) return 1.0;
+  if (ageUs >= DEAD_RECKON_BLEND_MS * 1000) return 0.0;
+  // Smoothstep, so the correction eases in and out
+  double t = ageUs / (DEAD_RECKON_BLEND_MS * 1000.0);
+  return 1.0 - t * t * (3 - 2 * t);
+}
+
+/**
+ * @brief Epoch time of a fix on the monotonic clock.
+ *
+ * A fix is received some delay after its epoch. The smallest delay seen is
+ * the best estimate of the fixed part, so anything above it is read jitter and
+ * is ignored. A larger jump (iTOW wrapping at the week, a receiver reset or a
+ * long outage) starts the estimate again.
+ */
+static int64_t epochTime(deadReckoner *dr, uint32_t iTOW, int64_t nowUs) {
+  int64_t epochUs = (int64_t)iTOW * 1000;
+  int64_t offsetUs = nowUs - epochUs;
+  if (!dr->valid || offsetUs < dr->clockOffsetUs || offsetUs - dr->clockOffsetUs > DEAD_RECKON_MAX_GAP_MS * 1000) {
+    dr->clockOffsetUs = offsetUs;
+  } else {
+    dr->clockOffsetUs += DEAD_RECKON_CLOCK_SLEW_US;
+  }
+  return epochUs + dr->clockOffsetUs;
+}
+
+void deadReckonFix(deadReckoner *dr, mapCoord fix, int32_t velN, int32_t velE, uint32_t iTOW, int64_t nowUs) {
+  mapCoord shown = deadReckonPosition(dr, nowUs);
+  bool wasValid = dr->valid;
+  dr->fixUs = epochTime(dr, iTOW, nowUs);
+  dr->valid = true;
+  dr->fix = fix;
+  dr->velN = velN;
+  dr->velE = velE;
+  dr->arrivedUs = nowUs;
+
+  // The new fix has already moved on since its epoch; blend from there
+  double offsetLat = 0, offsetLon = 0;
+  if (wasValid) {
+    double latE7, lonE7;
+    extrapolate(dr, nowUs, &latE7, &lonE7);
+    offsetLat = shown.latE7 - latE7;
+    offsetLon = shown.lonE7 - lonE7;
+    // A degree of longitude shrinks with cos(latitude), so compare in metres
+    double northM = offsetLat / 1e7 * METRES_PER_DEGREE;
+    double eastM = offsetLon / 1e7 * METRES_PER_DEGREE * cos(fix.latE7 / 1e7 * M_PI / 180.0);
+    if (hypot(northM, eastM) > DEAD_RECKON_SNAP_M) offsetLat = offsetLon = 0;
+  }
+  dr->offsetLatE7 = offsetLat;
+  dr->offsetLonE7 = offsetLon;
+}
+
+mapCoord deadReckonPosition(const deadReckoner *dr, int64_t nowUs) {
+  double latE7, lonE7;
+  extrapolate(dr, nowUs, &latE7, &lonE7);
+  double remaining = blendRemaining(dr, nowUs);
+  mapCoord shown;
+  shown.latE7 = (int32_t)lround(latE7 + dr->offsetLatE7 * remaining);
+  shown.lonE7 = (int32_t)lround(lonE7 + dr->offsetLonE7 * remaining);
+  return shown;
+}
+
+bool deadReckonMoving(const deadReckoner *dr, int64_t nowUs) {
+  if (!dr->valid) return false;
+  if (nowUs - dr->arrivedUs < DEAD_RECKON_BLEND_MS * 1000 && (dr->offsetLatE7 != 0 || dr->offsetLonE7 != 0)) return true;
+  return nowUs - dr->fixUs < DEAD_RECKON_MAX_GAP_MS * 1000 && hypot(dr->velN, dr->velE) >= DEAD_RECKON_MIN_SPEED_MM_S;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file        dead_reckon.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Extrapolates the displayed position between receiver fixes.
+ *
+ * @details     Between fixes the position is advanced along the last NED velocity, so
+ *              the marker can move every display frame while the receiver still reports
+ *              at 1-5 Hz. When a new fix arrives, the gap between where the marker was
+ *              drawn and the new fix is blended out over DEAD_RECKON_BLEND_MS instead of
+ *              jumping. Extrapolation stops DEAD_RECKON_MAX_GAP_MS after the last fix, so a
+ *              receiver outage freezes the marker rather than letting it drift away.
+ *
+ *              Times are monotonic microseconds (g_get_monotonic_time / frame clock).
+ *              Each fix is anchored at its epoch time (iTOW), mapped onto that clock
+ *              through the smallest receipt delay seen recently, so SPI and scheduling
+ *              jitter in when a fix is read does not move the extrapolated position.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef DEAD_RECKON_H
+#define DEAD_RECKON_H
+
+#include "map_projection.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Longest time a position is extrapolated past its fix
+#define DEAD_RECKON_MAX_GAP_MS 1500
+// Time over which the error at a new fix is blended out
+#define DEAD_RECKON_BLEND_MS 300
+// Below this ground speed the fix is shown as is (receiver velocity noise)
+#define DEAD_RECKON_MIN_SPEED_MM_S 500
+// Per-fix upward creep of the smallest receipt delay, so it follows clock drift
+#define DEAD_RECKON_CLOCK_SLEW_US 200
+
+/**
+ * @brief Extrapolation state for one moving position.
+ */
+typedef struct deadReckoner {
+  bool valid;
+  mapCoord fix;
+  int32_t velN;           // mm/s
+  int32_t velE;           // mm/s
+  int64_t fixUs;          // epoch time of the fix on the monotonic clock
+  int64_t arrivedUs;      // when the fix was received; the blend starts here
+  int64_t clockOffsetUs;  // smallest recent receipt time minus iTOW
+  double offsetLatE7;     // shown minus extrapolated fix at the moment the fix arrived
+  double offsetLonE7;
+} deadReckoner;
+
+/**
+ * @brief Starts extrapolating from a new fix.
+ *
+ * @param dr Extrapolation state
+ * @param fix Position of the fix
+ * @param velN North velocity in mm/s
+ * @param velE East velocity in mm/s
+ * @param iTOW GPS time of week of the fix in ms
+ * @param nowUs Time the fix was received
+ */
+void deadReckonFix(deadReckoner *dr, mapCoord fix, int32_t velN, int32_t velE, uint32_t iTOW, int64_t nowUs);
+
+/**
+ * @brief Position to display at nowUs.
+ */
+mapCoord deadReckonPosition(const deadReckoner *dr, int64_t nowUs);
+
+/**
+ * @brief True while the displayed position can still change without a new fix.
+ */
+bool deadReckonMoving(const deadReckoner *dr, int64_t nowUs);
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file        event_loop.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Custom GSources for running GPS and sensor I/O on the GTK thread.
+ *
+ * @details     Each source wraps one file descriptor polled by the GLib main context:
+ *              - the transport readiness descriptor, or a timerfd when the transport has none
+ *              - the GPS command queue eventfd, so queued commands are sent immediately
+ *              - a timerfd driving the (simulated) pressure sensor
+ *
+ *              Timer sources drain their expiration count before dispatching so the
+ *              descriptor does not stay readable. The GPS source reads with a bounded idle
+ *              scan so it never blocks the GUI waiting for the receiver.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "event_loop.h"
+#include "perf_stats.h"
+#include "gui_setup.h"
+#include "transport.h"
+#include "gps_command.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <glib.h>
+
+/**
+ * @brief GSource that dispatches its callback when a descriptor becomes readable.
+ */
+typedef struct fdSource {
+  GSource source;
+  gpointer tag;
+  int fd;
+  bool isTimer;  // drain timerfd expirations before dispatching
+  bool ownsFd;   // close the descriptor when the source is finalized
+} fdSource;
+
+static GSource *gpsSource = NULL;
+static GSource *commandSource = NULL;
+static GSource *pressureSource = NULL;
+
+static gboolean fdSourceCheck(GSource *source) {
+  fdSource *src = (fdSource *)source;
+  return (g_source_query_unix_fd(source, src->tag) & G_IO_IN) != 0;
+}
+
+static gboolean fdSourceDispatch(GSource *source, GSourceFunc callback, gpointer data) {
+  fdSource *src = (fdSource *)source;
+  if (src->isTimer) {
+    uint64_t expirations;
+    if (read(src->fd, &expirations, sizeof(expirations)) < 0) {
+      // Spurious wakeup; the timer has not actually expired
+      return G_SOURCE_CONTINUE;
+    }
+  }
+  return callback ? callback(data) : G_SOURCE_REMOVE;
+}
+
+static void fdSourceFinalize(GSource *source) {
+  fdSource *src = (fdSource *)source;
+  if (src->ownsFd && src->fd >= 0) close(src->fd);
+  src->fd = -1;
+}
+
+static GSourceFuncs fdSourceFuncs = {
+  NULL,
+  fdSourceCheck,
+  fdSourceDispatch,
+  fdSourceFinalize,
+  NULL,
+  NULL
+};
+
+/**
+ * @brief Creates a non-blocking periodic timerfd.
+ *
+ * @param periodMs Timer period in milliseconds
+ * @return int Descriptor, or -1 on failure
+ */
+static int createTimerFd(unsigned int periodMs) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0) {
+    perror("timerfd_create");
+    return -1;
+  }
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = periodMs / 1000;
+  spec.it_interval.tv_nsec = (periodMs % 1000) * 1000000L;
+  spec.it_value = spec.it_interval;
+  timerfd_settime(fd, 0, &spec, NULL);
+  return fd;
+}
+
+/**
+ * @brief Wraps a descriptor in an fdSource and attaches it to the default context.
+ */
+static GSource *attachFdSource(const char *name, int fd, bool isTimer, bool ownsFd,
+                               GSourceFunc callback, gpointer data) {
+  GSource *source = g_source_new(&fdSourceFuncs, sizeof(fdSource));
+  fdSource *src = (fdSource *)source;
+  src->fd = fd;
+  src->isTimer = isTimer;
+  src->ownsFd = ownsFd;
+  src->tag = g_source_add_unix_fd(source, fd, G_IO_IN);
+  g_source_set_name(source, name);
+  g_source_set_callback(source, callback, data, NULL);
+  g_source_attach(source, NULL);
+  return source;
+}
+
+/**
+ * @brief GPS source callback: drains any frames waiting on the transport.
+ */
+static gboolean onGpsReady(gpointer data) {
+  bufferStruct *buffers = (bufferStruct *)data;
+  if (!atomic_load(buffers->isRunning)) return G_SOURCE_REMOVE;
+  gpsPollFrames(buffers);
+  return G_SOURCE_CONTINUE;
+}
+
+/**
+ * @brief Command source callback: a command was queued, so send it without
+ *        waiting for the next transport or poll timer wakeup.
+ */
+static gboolean onCommandQueued(gpointer data) {
+  gpsCommandDrainFd();
+  return onGpsReady(data);
+}
+
+/**
+ * @brief Pressure source callback: advances the simulation and refreshes the icons.
+ */
+static gboolean onPressureTimer(gpointer data) {
+  stepPressureSimulation();
+  updatePressureDisplay(NULL);
+  return G_SOURCE_CONTINUE;
+}
+
+int eventLoopAttach(bufferStruct *buffers) {
+  // The receiver is read on this (the GTK) thread
+  perfRegisterReader();
+  int gpsFd = transportPollFd();
+  bool gpsIsTimer = false;
+  if (gpsFd < 0) {
+    gpsFd = createTimerFd(GPS_POLL_PERIOD_MS);
+    gpsIsTimer = true;
+    if (gpsFd < 0) return -1;
+  }
+  gpsSource = attachFdSource("gps", gpsFd, gpsIsTimer, gpsIsTimer, onGpsReady, buffers);
+
+  int commandFd = gpsCommandFd();
+  if (commandFd >= 0) {
+    commandSource = attachFdSource("gps-command", commandFd, false, false, onCommandQueued, buffers);
+  }
+
+  int pressureFd = createTimerFd(PRESSURE_PERIOD_S * 1000);
+  if (pressureFd < 0) {
+    eventLoopDetach();
+    return -1;
+  }
+  pressureSource = attachFdSource("pressure", pressureFd, true, true, onPressureTimer, NULL);
+
+  printf("Event loop mode: GPS on %s fd %d, pressure on timerfd %d\n",
+         gpsIsTimer ? "timer" : transportName(), gpsFd, pressureFd);
+  return 0;
+}
+
+void eventLoopDetach() {
+  if (gpsSource) {
+    g_source_destroy(gpsSource);
+    g_source_unref(gpsSource);
+    gpsSource = NULL;
+  }
+  if (commandSource) {
+    g_source_destroy(commandSource);
+    g_source_unref(commandSource);
+    commandSource = NULL;
+  }
+  if (pressureSource) {
+    g_source_destroy(pressureSource);
+    g_source_unref(pressureSource);
+    pressureSource = NULL;
+  }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file        event_loop.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Single-threaded integration of GPS and sensor I/O into the GTK main loop.
+ *
+ * @details     As an alternative to the dedicated GPS and pressure threads, the transport
+ *              readiness descriptor, sensor descriptors and timerfds can be attached to the
+ *              default GLib main context as custom GSources. Everything then runs on the GTK
+ *              thread, which removes thread wakeups, context switches and lock traffic on
+ *              small boards where each source has very little work to do.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "gps_setup.h"
+
+// Poll period for transports without a readiness descriptor (SPI has no data-ready line)
+#define GPS_POLL_PERIOD_MS 250
+
+/**
+ * @brief Attaches GPS, pressure and timer sources to the default main context.
+ *
+ * Must be called before the GTK main loop starts; sources dispatch once it runs.
+ *
+ * @param buffers Shared GPS buffers filled by the GPS source
+ * @return int 0 on success, -1 if a descriptor could not be created
+ */
+int eventLoopAttach(bufferStruct *buffers);
+
+/**
+ * @brief Removes all sources added by eventLoopAttach and closes their descriptors.
+ */
+void eventLoopDetach();
+
+#endif
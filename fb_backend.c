@@ -0,0 +1,203 @@
+/**
+ * @file        fb_backend.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Cairo rendering straight into a memory-mapped Linux framebuffer.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "fb_backend.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+
+static int fbFd = -1;
+static uint8_t *fbMem = NULL;
+static size_t fbMemLen = 0;
+static int width = 0;
+static int height = 0;
+static int stride = 0;
+static cairo_format_t format = CAIRO_FORMAT_INVALID;
+static bool isDevice = false;
+static int pages = 1;
+static int backPage = 0;
+static struct fb_var_screeninfo savedVar;   // mode found at open, restored at close
+static struct fb_var_screeninfo var;
+static cairo_surface_t *pageSurfaces[2] = {NULL, NULL};
+static cairo_surface_t *shadow = NULL;
+
+/**
+ * @brief Reads the geometry of a real framebuffer and asks for a second page.
+ *
+ * @return int Bits per pixel, or -1 if path is not a framebuffer device
+ */
+static int probeDevice() {
+  struct fb_fix_screeninfo fix;
+  if (ioctl(fbFd, FBIOGET_VSCREENINFO, &var) != 0) return -1;
+  savedVar = var;
+
+  // A virtual height of two screens lets frames be drawn off screen and panned in
+  bool modeChanged = false;
+  if (var.yres_virtual < 2 * var.yres) {
+    struct fb_var_screeninfo want = var;
+    want.yres_virtual = 2 * var.yres;
+    want.yoffset = 0;
+    if (ioctl(fbFd, FBIOPUT_VSCREENINFO, &want) == 0) {
+      modeChanged = true;
+      ioctl(fbFd, FBIOGET_VSCREENINFO, &var);
+    }
+  }
+  if (ioctl(fbFd, FBIOGET_FSCREENINFO, &fix) != 0) {
+    // fbClose only restores the mode of a device that probed successfully
+    if (modeChanged) ioctl(fbFd, FBIOPUT_VSCREENINFO, &savedVar);
+    return -1;
+  }
+
+  isDevice = true;
+  width = var.xres;
+  height = var.yres;
+  stride = fix.line_length;
+  fbMemLen = fix.smem_len;
+  pages = (var.yres_virtual >= 2 * var.yres && fbMemLen >= (size_t)stride * height * 2) ? 2 : 1;
+
+  if ((var.bits_per_pixel == 32 && var.red.offset != 16) || (var.bits_per_pixel == 16 && var.red.offset != 11)) {
+    printf("Warning: framebuffer is not XRGB8888/RGB565 ordered, colours may be swapped\n");
+  }
+  return var.bits_per_pixel;
+}
+
+int fbOpen(const char *path, int fileWidth, int fileHeight) {
+  fbFd = open(path, O_RDWR);
+  if (fbFd < 0) {
+    printf("Error: cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  int bpp = probeDevice();
+  if (bpp < 0) {
+    // A plain file stands in for the device: one 32 bpp page
+    isDevice = false;
+    width = fileWidth;
+    height = fileHeight;
+    bpp = 32;
+    stride = width * 4;
+    pages = 1;
+    fbMemLen = (size_t)stride * height;
+    if (ftruncate(fbFd, fbMemLen) != 0) {
+      printf("Error: cannot size %s: %s\n", path, strerror(errno));
+      fbClose();
+      return -1;
+    }
+  }
+
+  format = bpp == 32 ? CAIRO_FORMAT_RGB24 : bpp == 16 ? CAIRO_FORMAT_RGB16_565 : CAIRO_FORMAT_INVALID;
+  if (format == CAIRO_FORMAT_INVALID || stride < cairo_format_stride_for_width(format, width) || stride % 4 != 0) {
+    printf("Error: %s has an unsupported mode (%d bpp, stride %d)\n", path, bpp, stride);
+    fbClose();
+    return -1;
+  }
+
+  fbMem = mmap(NULL, fbMemLen, PROT_READ | PROT_WRITE, MAP_SHARED, fbFd, 0);
+  if (fbMem == MAP_FAILED) {
+    fbMem = NULL;
+    printf("Error: cannot map %s: %s\n", path, strerror(errno));
+    fbClose();
+    return -1;
+  }
+
+  for (int p = 0; p < pages; p++) {
+    pageSurfaces[p] = cairo_image_surface_create_for_data(fbMem + (size_t)p * stride * height, format,
+                                                          width, height, stride);
+  }
+  if (pages == 2) {
+    // Draw into whichever page is not on screen
+    backPage = var.yoffset >= (unsigned int)height ? 0 : 1;
+  } else {
+    shadow = cairo_image_surface_create(format, width, height);
+  }
+  printf("Framebuffer: %s, %dx%d %d bpp, %s\n", path, width, height, bpp,
+         pages == 2 ? "page flipping" : "shadow copy");
+  return 0;
+}
+
+int fbWidth() {
+  return width;
+}
+
+int fbHeight() {
+  return height;
+}
+
+bool fbPageFlipping() {
+  return pages == 2;
+}
+
+cairo_surface_t *fbBackSurface() {
+  return pages == 2 ? pageSurfaces[backPage] : shadow;
+}
+
+void fbPresent() {
+  if (pages == 2) {
+    cairo_surface_flush(pageSurfaces[backPage]);
+    var.yoffset = backPage * height;
+    ioctl(fbFd, FBIOPAN_DISPLAY, &var);
+    // The old front page is only free once the pan has taken effect
+    int crtc = 0;
+    ioctl(fbFd, FBIO_WAITFORVSYNC, &crtc);
+    backPage ^= 1;
+    return;
+  }
+
+  cairo_surface_flush(shadow);
+  const uint8_t *src = cairo_image_surface_get_data(shadow);
+  int srcStride = cairo_image_surface_get_stride(shadow);
+  int rowBytes = cairo_format_stride_for_width(format, width);
+  for (int y = 0; y < height; y++) {
+    memcpy(fbMem + (size_t)y * stride, src + (size_t)y * srcStride, rowBytes);
+  }
+}
+
+void fbClose() {
+  for (int p = 0; p < 2; p++) {
+    if (pageSurfaces[p]) cairo_surface_destroy(pageSurfaces[p]);
+    pageSurfaces[p] = NULL;
+  }
+  if (shadow) cairo_surface_destroy(shadow);
+  shadow = NULL;
+  if (fbMem) munmap(fbMem, fbMemLen);
+  fbMem = NULL;
+  if (fbFd >= 0) {
+    if (isDevice) ioctl(fbFd, FBIOPUT_VSCREENINFO, &savedVar);
+    close(fbFd);
+  }
+  fbFd = -1;
+  isDevice = false;
+  pages = 1;
+}
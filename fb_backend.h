@@ -0,0 +1,91 @@
+/**
+ * @file        fb_backend.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Cairo rendering straight into a memory-mapped Linux framebuffer.
+ *
+ * @details     For kiosk installs with no X or Wayland. The framebuffer is mapped once and
+ *              wrapped in cairo image surfaces, so frames are drawn in place with no copy:
+ *              - if the driver accepts a virtual height of two screens, frames are drawn
+ *                into the hidden page and shown with FBIOPAN_DISPLAY (page flipping),
+ *                waiting for vertical sync where the driver supports it;
+ *              - otherwise frames are drawn into an off-screen shadow and copied in one
+ *                pass, so a half-drawn frame is never visible.
+ *
+ *              A plain file can stand in for the device (for tests): it is sized to one
+ *              32 bpp page of the given geometry and written through the shadow path.
+ *
+ *              32 bpp (XRGB8888) and 16 bpp (RGB565) modes are supported. The backend
+ *              is a singleton used from one thread.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef FB_BACKEND_H
+#define FB_BACKEND_H
+
+#include <stdbool.h>
+#include <cairo.h>
+
+// Framebuffer used when none is given
+#define FB_DEFAULT_DEVICE "/dev/fb0"
+
+/**
+ * @brief Maps a framebuffer device, or a plain file standing in for one.
+ *
+ * @param path Device node (e.g. /dev/fb0) or regular file
+ * @param fileWidth Page width used when path is a plain file
+ * @param fileHeight Page height used when path is a plain file
+ * @return int 0 on success, -1 on failure (reason printed)
+ */
+int fbOpen(const char *path, int fileWidth, int fileHeight);
+
+/**
+ * @brief Visible size in pixels.
+ */
+int fbWidth();
+int fbHeight();
+
+/**
+ * @brief True if frames are shown by page flipping rather than copied.
+ */
+bool fbPageFlipping();
+
+/**
+ * @brief Surface the next frame should be drawn into.
+ *
+ * Valid until the next fbPresent; do not destroy it.
+ */
+cairo_surface_t *fbBackSurface();
+
+/**
+ * @brief Shows the frame drawn into fbBackSurface.
+ */
+void fbPresent();
+
+/**
+ * @brief Restores the original display mode and unmaps the framebuffer.
+ */
+void fbClose();
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * @file        gps_command.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Asynchronous UBX command queue with ACK/NACK correlation.
+ *
+ * @details     Commands live in a fixed table of slots guarded by one mutex. A slot moves
+ *              QUEUED -> IN_FLIGHT when the reader transmits it and is freed when the
+ *              matching ACK/NACK, poll response or timeout completes it. The receiver also
+ *              ACKs CFG polls after sending the response, so a completed poll stays DRAINING
+ *              until that trailing ACK arrives; this keeps the class/ID blocked and stops the
+ *              ACK being credited to the next command with the same class/ID.
+ *
+ *              Callbacks are always invoked with the mutex released so they may queue
+ *              follow-up commands.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "gps_command.h"
+#include "perf_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#define HEADER1 0xB5
+#define HEADER2 0x62
+#define ACK_CLASS 0x05
+#define ACK_ACK 0x01
+#define ACK_NAK 0x00
+
+/**
+ * @brief Lifecycle of a command slot.
+ */
+typedef enum slotState {
+  SLOT_FREE,
+  SLOT_QUEUED,     // waiting for the reader to transmit it
+  SLOT_IN_FLIGHT,  // transmitted, waiting for ACK/NACK or poll response
+  SLOT_DRAINING    // poll answered, swallowing the receiver's trailing ACK
+} slotState;
+
+/**
+ * @brief One queued or in-flight command.
+ */
+typedef struct commandSlot {
+  slotState state;
+  uint32_t seq;       // submission order, so same-class/ID commands go out FIFO
+  uint8_t cls;
+  uint8_t id;
+  bool isPoll;
+  uint8_t frame[GPS_COMMAND_MAX_FRAME];
+  uint16_t frameLen;
+  uint32_t timeoutMs;
+  int64_t queuedUs;
+  int64_t deadlineUs;
+  gpsCommandCallback callback;
+  void *userData;
+} commandSlot;
+
+/**
+ * @brief Callback captured under the lock and invoked after releasing it.
+ */
+typedef struct completion {
+  gpsCommandCallback callback;
+  void *userData;
+  gpsCommandResult result;
+} completion;
+
+static commandSlot slots[GPS_COMMAND_SLOTS];
+static uint32_t nextSeq = 0;
+static int pendingCount = 0;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Output period last ACKed by the receiver (measRate * navRate)
+static atomic_uint epochPeriodMs = 1000;
+
+static int wakeFd = -1;
+static pthread_once_t wakeFdOnce = PTHREAD_ONCE_INIT;
+
+static void createWakeFd() {
+  wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeFd < 0) perror("eventfd");
+}
+
+int gpsCommandFd() {
+  pthread_once(&wakeFdOnce, createWakeFd);
+  return wakeFd;
+}
+
+void gpsCommandDrainFd() {
+  uint64_t count;
+  if (gpsCommandFd() >= 0 && read(wakeFd, &count, sizeof(count)) < 0) {
+    // Nothing pending; the descriptor was not readable
+  }
+}
+
+static void signalWakeFd() {
+  uint64_t one = 1;
+  if (gpsCommandFd() >= 0 && write(wakeFd, &one, sizeof(one)) < 0) {
+    perror("eventfd write");
+  }
+}
+
+int gpsCommandSubmitFrame(const uint8_t *frame, uint16_t len, bool isPoll,
+                          uint32_t timeoutMs, gpsCommandCallback callback, void *userData) {
+  if (len < 8 || len > GPS_COMMAND_MAX_FRAME || frame[0] != HEADER1 || frame[1] != HEADER2 ||
+      (uint16_t)(frame[4] | (frame[5] << 8)) + 8 != len) {
+    printf("Rejected malformed UBX command (%u bytes)\n", len);
+    return -1;
+  }
+
+  pthread_mutex_lock(&queueLock);
+  commandSlot *slot = NULL;
+  for (int i = 0; i < GPS_COMMAND_SLOTS; i++) {
+    if (slots[i].state == SLOT_FREE) {
+      slot = &slots[i];
+      break;
+    }
+  }
+  if (!slot) {
+    pthread_mutex_unlock(&queueLock);
+    printf("GPS command queue full, dropping cls=0x%02X id=0x%02X\n", frame[2], frame[3]);
+    return -1;
+  }
+  slot->state = SLOT_QUEUED;
+  slot->seq = nextSeq++;
+  slot->cls = frame[2];
+  slot->id = frame[3];
+  slot->isPoll = isPoll;
+  memcpy(slot->frame, frame, len);
+  slot->frameLen = len;
+  slot->timeoutMs = timeoutMs;
+  slot->queuedUs = perfNowUs();
+  slot->deadlineUs = 0;
+  slot->callback = callback;
+  slot->userData = userData;
+  pendingCount++;
+  pthread_mutex_unlock(&queueLock);
+
+  signalWakeFd();
+  return 0;
+}
+
+int gpsCommandSubmit(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len, bool isPoll,
+                     uint32_t timeoutMs, gpsCommandCallback callback, void *userData) {
+  uint8_t frame[GPS_COMMAND_MAX_FRAME];
+  if ((uint32_t)len + 8 > sizeof(frame)) {
+    printf("UBX command payload too large (%u bytes)\n", len);
+    return -1;
+  }
+  frame[0] = HEADER1;
+  frame[1] = HEADER2;
+  frame[2] = cls;
+  frame[3] = id;
+  frame[4] = len & 0xFF;
+  frame[5] = len >> 8;
+  if (len > 0) memcpy(&frame[6], payload, len);
+  calculateUBXChecksum(&frame[2], len + 4, &frame[6 + len], &frame[7 + len]);
+  return gpsCommandSubmitFrame(frame, len + 8, isPoll, timeoutMs, callback, userData);
+}
+
+/**
+ * @brief True if a command with this class/ID is waiting on the receiver.
+ */
+static bool classBusy(uint8_t cls, uint8_t id) {
+  for (int i = 0; i < GPS_COMMAND_SLOTS; i++) {
+    if ((slots[i].state == SLOT_IN_FLIGHT || slots[i].state == SLOT_DRAINING) &&
+        slots[i].cls == cls && slots[i].id == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t gpsCommandNextToSend(uint8_t *out, uint16_t capacity) {
+  pthread_mutex_lock(&queueLock);
+  commandSlot *next = NULL;
+  for (int i = 0; i < GPS_COMMAND_SLOTS; i++) {
+    commandSlot *slot = &slots[i];
+    if (slot->state != SLOT_QUEUED || slot->frameLen > capacity) continue;
+    if (next && (int32_t)(slot->seq - next->seq) > 0) continue;
+    if (classBusy(slot->cls, slot->id)) continue;
+    next = slot;
+  }
+  uint16_t len = 0;
+  if (next) {
+    memcpy(out, next->frame, next->frameLen);
+    len = next->frameLen;
+    next->state = SLOT_IN_FLIGHT;
+    next->deadlineUs = perfNowUs() + (int64_t)next->timeoutMs * 1000;
+  }
+  pthread_mutex_unlock(&queueLock);
+  return len;
+}
+
+static void freeSlot(commandSlot *slot) {
+  slot->state = SLOT_FREE;
+  pendingCount--;
+}
+
+bool gpsCommandHandleFrame(const incomingUBX *frame) {
+  bool isAck = frame->msgCls == ACK_CLASS && (frame->msgID == ACK_ACK || frame->msgID == ACK_NAK);
+  if (isAck && frame->msgLen != 2) return false;
+  uint8_t cls = isAck ? frame->payload[0] : frame->msgCls;
+  uint8_t id = isAck ? frame->payload[1] : frame->msgID;
+
+  pthread_mutex_lock(&queueLock);
+  commandSlot *slot = NULL;
+  for (int i = 0; i < GPS_COMMAND_SLOTS; i++) {
+    if ((slots[i].state == SLOT_IN_FLIGHT || slots[i].state == SLOT_DRAINING) &&
+        slots[i].cls == cls && slots[i].id == id) {
+      slot = &slots[i];
+      break;
+    }
+  }
+  if (!slot || (!isAck && !(slot->isPoll && slot->state == SLOT_IN_FLIGHT))) {
+    pthread_mutex_unlock(&queueLock);
+    return false;
+  }
+
+  completion done = {NULL, NULL, GPS_CMD_ACK};
+  const incomingUBX *response = NULL;
+  if (slot->state == SLOT_IN_FLIGHT) perfNoteCommandLatency(perfNowUs() - slot->queuedUs);
+  if (slot->state == SLOT_DRAINING) {
+    // Trailing ACK of a poll that was already answered
+    freeSlot(slot);
+  } else if (!isAck) {
+    // Poll response: complete now, keep the class/ID blocked until its ACK follows
+    done = (completion){slot->callback, slot->userData, GPS_CMD_ACK};
+    response = frame;
+    slot->state = SLOT_DRAINING;
+  } else {
+    done = (completion){slot->callback, slot->userData,
+                        frame->msgID == ACK_ACK ? GPS_CMD_ACK : GPS_CMD_NAK};
+    freeSlot(slot);
+  }
+  pthread_mutex_unlock(&queueLock);
+
+  if (done.callback) done.callback(done.result, response, done.userData);
+  return true;
+}
+
+void gpsCommandExpire() {
+  completion expired[GPS_COMMAND_SLOTS];
+  int count = 0;
+  int64_t now = perfNowUs();
+
+  pthread_mutex_lock(&queueLock);
+  for (int i = 0; i < GPS_COMMAND_SLOTS; i++) {
+    commandSlot *slot = &slots[i];
+    if (slot->state != SLOT_IN_FLIGHT && slot->state != SLOT_DRAINING) continue;
+    if (now < slot->deadlineUs) continue;
+    if (slot->state == SLOT_IN_FLIGHT) {
+      expired[count++] = (completion){slot->callback, slot->userData, GPS_CMD_TIMEOUT};
+    }
+    freeSlot(slot);
+  }
+  pthread_mutex_unlock(&queueLock);
+
+  for (int i = 0; i < count; i++) {
+    if (expired[i].callback) expired[i].callback(GPS_CMD_TIMEOUT, NULL, expired[i].userData);
+  }
+}
+
+int gpsCommandPending() {
+  pthread_mutex_lock(&queueLock);
+  int pending = pendingCount;
+  pthread_mutex_unlock(&queueLock);
+  return pending;
+}
+
+/**
+ * @brief Pending CFG-RATE change, kept until the receiver answers.
+ */
+typedef struct rateRequest {
+  uint32_t periodMs;
+  gpsCommandCallback callback;
+  void *userData;
+} rateRequest;
+
+/**
+ * @brief Adopts the new epoch period once the receiver has ACKed it.
+ */
+static void rateRequestDone(gpsCommandResult result, const incomingUBX *response, void *userData) {
+  rateRequest *request = (rateRequest *)userData;
+  if (result == GPS_CMD_ACK) atomic_store(&epochPeriodMs, request->periodMs);
+  if (request->callback) request->callback(result, response, request->userData);
+  free(request);
+}
+
+int gpsSetRate(uint16_t measRateMs, uint16_t navRate, gpsCommandCallback callback, void *userData) {
+  if (measRateMs == 0 || navRate == 0) return -1;
+  uint8_t payload[6] = {measRateMs & 0xFF, measRateMs >> 8, navRate & 0xFF, navRate >> 8, 0x00, 0x00};
+
+  rateRequest *request = (rateRequest *)malloc(sizeof(rateRequest));
+  request->periodMs = (uint32_t)measRateMs * navRate;
+  request->callback = callback;
+  request->userData = userData;
+  if (gpsCommandSubmit(0x06, 0x08, payload, sizeof(payload), false, GPS_COMMAND_TIMEOUT_MS,
+                       rateRequestDone, request) != 0) {
+    free(request);
+    return -1;
+  }
+  return 0;
+}
+
+int gpsSetMessageRate(uint8_t cls, uint8_t id, uint8_t rate, gpsCommandCallback callback, void *userData) {
+  // Per-port rates: I2C, UART1, UART2, USB, SPI, reserved
+  uint8_t payload[8] = {cls, id, 0x00, 0x00, 0x00, 0x00, rate, 0x00};
+  return gpsCommandSubmit(0x06, 0x01, payload, sizeof(payload), false, GPS_COMMAND_TIMEOUT_MS,
+                          callback, userData);
+}
+
+uint32_t gpsCommandEpochPeriodMs() {
+  return atomic_load(&epochPeriodMs);
+}
@@ -0,0 +1,175 @@
+/**
+ * @file        gps_command.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Asynchronous UBX command queue with ACK/NACK correlation.
+ *
+ * @details     Commands can be queued from any thread at any time, including while NAV-PVT
+ *              output is streaming. The GPS reader interleaves queued commands with its
+ *              reads and hands every received frame to this module, which completes the
+ *              matching command when its UBX-ACK-ACK / UBX-ACK-NAK (matched by class and ID)
+ *              or poll response arrives, or when its timeout expires.
+ *
+ *              Only one command per class/ID is in flight at a time, since an ACK carries
+ *              nothing but the class/ID it acknowledges. Completion callbacks run on the
+ *              reader's thread; GUI code should hop to the main loop with g_idle_add.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef GPS_COMMAND_H
+#define GPS_COMMAND_H
+
+#include "gps_setup.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Commands that can be queued or in flight at once
+#define GPS_COMMAND_SLOTS 16
+// Largest command or poll response frame stored by the queue
+#define GPS_COMMAND_MAX_FRAME 128
+// Default time allowed for the ACK/NACK or poll response
+#define GPS_COMMAND_TIMEOUT_MS 1000
+
+/**
+ * @brief How a queued command finished.
+ */
+typedef enum gpsCommandResult {
+  GPS_CMD_ACK,      // UBX-ACK-ACK received (for polls: response received)
+  GPS_CMD_NAK,      // UBX-ACK-NAK received
+  GPS_CMD_TIMEOUT   // nothing matching arrived before the deadline
+} gpsCommandResult;
+
+/**
+ * @brief Completion callback, run on the GPS reader's thread.
+ *
+ * @param result How the command finished
+ * @param response Poll response frame, or NULL for set commands and failures
+ * @param userData Pointer given when the command was queued
+ */
+typedef void (*gpsCommandCallback)(gpsCommandResult result, const incomingUBX *response, void *userData);
+
+/**
+ * @brief Queues a UBX command built from class, ID and payload.
+ *
+ * Thread-safe. The checksum is computed here.
+ *
+ * @param cls Message class
+ * @param id Message ID
+ * @param payload Payload bytes (may be NULL when len is 0)
+ * @param len Payload length
+ * @param isPoll True if the receiver answers with a message of the same class/ID
+ * @param timeoutMs Deadline for the ACK/NACK or response, measured from transmission
+ * @param callback Optional completion callback
+ * @param userData Passed to the callback
+ * @return int 0 on success, -1 if the queue is full or the frame is too large
+ */
+int gpsCommandSubmit(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len, bool isPoll,
+                     uint32_t timeoutMs, gpsCommandCallback callback, void *userData);
+
+/**
+ * @brief Queues an already framed UBX command (sync, header, payload, checksum).
+ *
+ * @return int 0 on success, -1 if the queue is full or the frame is malformed
+ */
+int gpsCommandSubmitFrame(const uint8_t *frame, uint16_t len, bool isPoll,
+                          uint32_t timeoutMs, gpsCommandCallback callback, void *userData);
+
+/**
+ * @brief Copies the next sendable command into out and marks it in flight.
+ *
+ * Reader side. A command is sendable when no other command with the same
+ * class/ID is awaiting its ACK.
+ *
+ * @return uint16_t Frame length, or 0 if nothing can be sent
+ */
+uint16_t gpsCommandNextToSend(uint8_t *out, uint16_t capacity);
+
+/**
+ * @brief Offers a received frame to the queue.
+ *
+ * Reader side. Completes the matching in-flight command on ACK-ACK/ACK-NAK or
+ * on a poll response.
+ *
+ * @return bool True if the frame was consumed by the queue
+ */
+bool gpsCommandHandleFrame(const incomingUBX *frame);
+
+/**
+ * @brief Times out in-flight commands whose deadline has passed.
+ *
+ * Reader side; call regularly.
+ */
+void gpsCommandExpire();
+
+/**
+ * @brief Number of commands queued or in flight.
+ */
+int gpsCommandPending();
+
+/**
+ * @brief eventfd that becomes readable whenever a command is queued.
+ *
+ * Lets a sleeping reader (thread or main loop source) wake up to send it.
+ */
+int gpsCommandFd();
+
+/**
+ * @brief Clears the readiness of gpsCommandFd.
+ */
+void gpsCommandDrainFd();
+
+/**
+ * @brief Queues a CFG-RATE change; safe to call from any thread while streaming.
+ *
+ * Output period is measRateMs * navRate. gpsCommandEpochPeriodMs only changes
+ * once the receiver ACKs, so the reader's pacing never runs ahead of the receiver.
+ *
+ * @param measRateMs Measurement period in milliseconds
+ * @param navRate Measurements per navigation solution
+ * @param callback Optional completion callback
+ * @param userData Passed to the callback
+ * @return int 0 if queued, -1 otherwise
+ */
+int gpsSetRate(uint16_t measRateMs, uint16_t navRate, gpsCommandCallback callback, void *userData);
+
+/**
+ * @brief Queues a CFG-MSG change setting how often a message is output on SPI.
+ *
+ * @param cls Message class
+ * @param id Message ID
+ * @param rate Output once every N navigation solutions, 0 to disable
+ * @param callback Optional completion callback
+ * @param userData Passed to the callback
+ * @return int 0 if queued, -1 otherwise
+ */
+int gpsSetMessageRate(uint8_t cls, uint8_t id, uint8_t rate, gpsCommandCallback callback, void *userData);
+
+/**
+ * @brief Output period (ms) of the last CFG-RATE the receiver acknowledged.
+ *
+ * Defaults to 1000 until a rate change is ACKed.
+ */
+uint32_t gpsCommandEpochPeriodMs();
+
+#endif
@@ -9,12 +9,13 @@
  *              module using the UBX binary protocol via SPI on a Raspberry Pi. This file handles:
  *              - Sending configuration and polling commands to the GPS module
  *              - Parsing UBX responses such as NAV-PVT, CFG-RATE, and CFG-MSG
- *              - Verifying ACK/NACK responses to configuration commands
+ *              - Sending queued commands between reads and routing ACK/NACK and poll
+ *                responses back to the command queue (gps_command.c)
  *              - Spawning a GPS readout thread that buffers and prints positional data
  *              - Integrating with a GUI via idle callbacks for display updates
  *
  *              Functions support both startup polling and continuous runtime parsing.
- *              Communication is managed using the BCM2835 SPI library.
+ *              Bytes are exchanged through the transport layer (SPI or simulated receiver).
  *
  * @license     MIT License
  *              Copyright (c) 2025 Joshua Anselm
@@ -40,15 +41,18 @@
 
 #include "gps_setup.h"
 #include "gui_setup.h"
+#include "transport.h"
+#include "perf_stats.h"
+#include "gps_command.h"
 #include <stdbool.h>
 #include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
-#include <bcm2835.h>
 #include <arpa/inet.h>
 #include <pthread.h>
+#include <poll.h>
 
 #define HEADER1 0xB5
 #define HEADER2 0x62
@@ -56,10 +60,78 @@
 
 atomic_bool *gpsRunning;
 
+/**
+ * @brief Computes the 8-bit Fletcher checksum used by UBX frames.
+ *
+ * @param msg Bytes from the class field through the end of the payload
+ * @param length Number of bytes in msg
+ * @param ck_a Output for the first checksum byte
+ * @param ck_b Output for the second checksum byte
+ */
+void calculateUBXChecksum(const uint8_t *msg, uint16_t length, uint8_t *ck_a, uint8_t *ck_b) {
+  *ck_a = 0;
+  *ck_b = 0;
+  for (uint16_t i = 0; i < length; i++) {
+    *ck_a = *ck_a + msg[i];
+    *ck_b = *ck_b + *ck_a;
+  }
+}
+
+//////////////// COMMAND RESULTS //////////////////
+
+/**
+ * @brief Prints the outcome of a queued set command.
+ *
+ * @param userData Label string given when the command was queued
+ */
+static void logCommandResult(gpsCommandResult result, const incomingUBX *response, void *userData) {
+  const char *label = (const char *)userData;
+  if (result == GPS_CMD_ACK) {
+    printf("ACK received for %s\n", label);
+  } else if (result == GPS_CMD_NAK) {
+    printf("NACK received for %s\n", label);
+  } else {
+    printf("Timed out waiting for ACK after %s\n", label);
+  }
+}
+
+/**
+ * @brief Dispatches a CFG poll response for specific parsing.
+ */
+static void handlePollResponse(gpsCommandResult result, const incomingUBX *response, void *userData) {
+  const char *name = userData;
+  switch (result) {
+    case GPS_CMD_NAK:
+      printf("%s poll rejected (NAK)\n", name);
+      return;
+    case GPS_CMD_TIMEOUT:
+      printf("Timed out waiting for %s poll response\n", name);
+      return;
+    case GPS_CMD_ACK:
+      if (!response) {
+        printf("%s poll acknowledged without a response\n", name);
+        return;
+      }
+      break;
+  }
+
+  printf("Received poll response: class=0x%02X id=0x%02X len=%d\n",
+    response->msgCls, response->msgID, response->msgLen);
+
+  if (response->msgID == 0x01 && response->msgLen >= 8) {
+    checkConfigMsgSettings(response->payload);
+  } else if (response->msgID == 0x08 && response->msgLen >= 6) {
+    checkRateSettings(response->payload);
+  } else {
+    printf("Unrecognized poll response: class=0x%02X id=0x%02X\n",
+            response->msgCls, response->msgID);
+  }
+}
+
 //////////////// POLLING MESSAGES //////////////////
 
 /**
- * @brief Sends a UBX command to poll the NAV-PVT message settings.
+ * @brief Queues a UBX command to poll the NAV-PVT message settings.
  *
  * Expected to receive a response containing the configuration of
  * the NAV-PVT message enablement, typically with a payload of 8 bytes.
@@ -67,11 +139,12 @@ atomic_bool *gpsRunning;
 void pollNavPVT() {
   printf("Polling NAV-PVT configuration...\n");
   uint8_t pollNavPVT[] = {0xB5, 0x62, 0x06, 0x01, 0x02, 0x00, 0x01, 0x07, 0x11, 0x3A};
-  bcm2835_spi_transfern((char*)pollNavPVT, sizeof(pollNavPVT));
+  gpsCommandSubmitFrame(pollNavPVT, sizeof(pollNavPVT), true, GPS_RESPONSE_TIMEOUT_MS,
+                        handlePollResponse, "CFG-MSG");
 }
 
 /**
- * @brief Sends a UBX command to poll the module's navigation rate configuration.
+ * @brief Queues a UBX command to poll the module's navigation rate configuration.
  *
  * Expected to receive a response describing the solution and measurement rates,
  * with a payload of 6 bytes.
@@ -79,7 +152,8 @@ void pollNavPVT() {
 void pollRate() {
   printf("Polling nav measurement and solution rate...\n");
   uint8_t pollRate[] = {0xB5, 0x62, 0x06, 0x08, 0x00, 0x00, 0x0E, 0x30};
-  bcm2835_spi_transfern((char*)pollRate, sizeof(pollRate));
+  gpsCommandSubmitFrame(pollRate, sizeof(pollRate), true, GPS_RESPONSE_TIMEOUT_MS,
+                        handlePollResponse, "CFG-RATE");
 }
 
 //////////////// CONFIGURATION MESSAGES //////////////////
@@ -87,25 +161,25 @@ void pollRate() {
 /**
  * @brief Configures the GPS module to use UBX protocol only over SPI.
  *
- * Sends a CFG-PRT message to restrict input/output to UBX only,
+ * Queues a CFG-PRT message to restrict input/output to UBX only,
  * targeting the SPI interface settings.
  */
 void setProtocol_UBX() {
   uint8_t cfg_ubx_only[] = {0xb5, 0x62, 0x06, 0x00, 0x14, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 
     0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x52, 0x94};
-  bcm2835_spi_transfern((char *)cfg_ubx_only, sizeof(cfg_ubx_only));
-  printf("SET PROTOCOL UBX: SENT\n");
+  gpsCommandSubmitFrame(cfg_ubx_only, sizeof(cfg_ubx_only), false, GPS_RESPONSE_TIMEOUT_MS,
+                        logCommandResult, "setProtocol_UBX");
+  printf("SET PROTOCOL UBX: QUEUED\n");
 }
 
 /**
  * @brief Enables periodic NAV-PVT messages from the GPS module.
  *
- * Sends a CFG-MSG command to enable NAV-PVT output over the SPI interface.
+ * Queues a CFG-MSG command to enable NAV-PVT output over the SPI interface.
  */
 void enable_navPVT() {
-  uint8_t config_navpt_on[] = {0xb5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x01, 0x07, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x18, 0xde};
-  bcm2835_spi_transfern((char *)config_navpt_on, sizeof(config_navpt_on));
-  printf("UBX NAV-PVT ON: SENT\n");
+  gpsSetMessageRate(0x01, 0x07, 1, logCommandResult, "enable_navPVT");
+  printf("UBX NAV-PVT ON: QUEUED\n");
 }
 
 /**
@@ -115,9 +189,8 @@ void enable_navPVT() {
  * This results in two measurements per message, output every 500ms.
  */
 void setRate_4x2() {
-  uint8_t config_rate_4x2hz[] = {0xb5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xfa, 0x00, 0x02, 0x00, 0x00, 0x00, 0x10, 0x98};
-  bcm2835_spi_transfern((char *)config_rate_4x2hz, sizeof(config_rate_4x2hz));
-  printf("RATE CONFIG 2hz: SENT\n");
+  gpsSetRate(250, 2, logCommandResult, "setRate_4x2");
+  printf("RATE CONFIG 2hz: QUEUED\n");
 }
 
 /**
@@ -127,56 +200,260 @@ void setRate_4x2() {
  * Output uses UTC as the time reference.
  */
 void setRate_2x1() {
-  uint8_t config_rate_2x1hz[] = {0xb5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xF4, 0x01, 0x02, 0x00, 0x00, 0x00, 0x0B, 0x79};
-  bcm2835_spi_transfern((char *)config_rate_2x1hz, sizeof(config_rate_2x1hz));
-  printf("RATE CONFIG 2hz: SENT\n");
+  gpsSetRate(500, 2, logCommandResult, "setRate_2x1");
+  printf("RATE CONFIG 1hz: QUEUED\n");
 }
 
-//////////////// READING MESSAGES //////////////////
+//////////////// FRAME PARSER //////////////////
 
 /**
- * @brief Reads a UBX poll response message during startup.
+ * @brief States of the incremental UBX frame parser.
+ */
+typedef enum parseState {
+  PARSE_SYNC1,
+  PARSE_SYNC2,
+  PARSE_CLASS,
+  PARSE_ID,
+  PARSE_LEN1,
+  PARSE_LEN2,
+  PARSE_PAYLOAD,
+  PARSE_CK_A,
+  PARSE_CK_B
+} parseState;
+
+/**
+ * @brief Incremental parser over the receiver byte stream.
  *
- * Waits for a valid UBX header, reads class, ID, and payload, then
- * dispatches the message for specific parsing based on type.
+ * State persists between reads, so a read that stops mid-frame (deadline or
+ * idle budget) resumes where the receiver left off on the next call.
  */
-void readPollResponse() {
-  printf("Reading poll response...\n");
+typedef struct ubxParser {
+  parseState state;
+  uint16_t pos;
+  uint8_t ck_a;
+  uint8_t ck_b;
+  incomingUBX frame;
+  uint8_t payload[GPS_MAX_PAYLOAD];
+} ubxParser;
+
+static ubxParser rxParser = { .state = PARSE_SYNC1 };
+static atomic_ulong checksumErrors;
+static atomic_ulong lengthErrors;
 
-  incomingUBX pollResponse;
+/**
+ * @brief Adds a class/ID/length/payload byte to the running checksum.
+ */
+static inline void ubxParserChecksum(ubxParser *p, uint8_t b) {
+  p->ck_a += b;
+  p->ck_b += p->ck_a;
+}
 
-  uint16_t header = 0xFFFF;
-  while(header != 0xB562) {
-    header = (header << 8) | bcm2835_spi_transfer(0xFF);
+/**
+ * @brief Feeds one received byte to the parser.
+ *
+ * Frames with an impossible length or a bad checksum are dropped and the
+ * parser goes back to hunting for the sync header (resynchronisation).
+ *
+ * @return int 1 when a valid frame is complete, -1 when a frame was rejected, 0 otherwise
+ */
+static int ubxParserFeed(ubxParser *p, uint8_t b) {
+  switch (p->state) {
+    case PARSE_SYNC1:
+      if (b == HEADER1) p->state = PARSE_SYNC2;
+      return 0;
+    case PARSE_SYNC2:
+      p->state = (b == HEADER2) ? PARSE_CLASS : (b == HEADER1 ? PARSE_SYNC2 : PARSE_SYNC1);
+      return 0;
+    case PARSE_CLASS:
+      p->frame.sync1 = HEADER1;
+      p->frame.sync2 = HEADER2;
+      p->frame.msgCls = b;
+      p->frame.payload = p->payload;
+      p->ck_a = 0;
+      p->ck_b = 0;
+      ubxParserChecksum(p, b);
+      p->state = PARSE_ID;
+      return 0;
+    case PARSE_ID:
+      p->frame.msgID = b;
+      ubxParserChecksum(p, b);
+      p->state = PARSE_LEN1;
+      return 0;
+    case PARSE_LEN1:
+      p->frame.msgLen = b;
+      ubxParserChecksum(p, b);
+      p->state = PARSE_LEN2;
+      return 0;
+    case PARSE_LEN2:
+      p->frame.msgLen |= b << 8;
+      ubxParserChecksum(p, b);
+      if (p->frame.msgLen > GPS_MAX_PAYLOAD) {
+        atomic_fetch_add(&lengthErrors, 1);
+        p->state = PARSE_SYNC1;
+        return -1;
+      }
+      p->pos = 0;
+      p->state = (p->frame.msgLen > 0) ? PARSE_PAYLOAD : PARSE_CK_A;
+      return 0;
+    case PARSE_PAYLOAD:
+      p->payload[p->pos++] = b;
+      ubxParserChecksum(p, b);
+      if (p->pos == p->frame.msgLen) p->state = PARSE_CK_A;
+      return 0;
+    case PARSE_CK_A:
+      p->frame.ck_a = b;
+      p->state = PARSE_CK_B;
+      return 0;
+    case PARSE_CK_B:
+      p->frame.ck_b = b;
+      p->state = PARSE_SYNC1;
+      if (p->frame.ck_a != p->ck_a || p->frame.ck_b != p->ck_b) {
+        atomic_fetch_add(&checksumErrors, 1);
+        return -1;
+      }
+      return 1;
   }
+  return 0;
+}
 
-  pollResponse.msgCls = bcm2835_spi_transfer(0xFF);
-  pollResponse.msgID = bcm2835_spi_transfer(0xFF);
-  pollResponse.msgLen = bcm2835_spi_transfer(0xFF);
-  pollResponse.msgLen |= bcm2835_spi_transfer(0xFF) << 8;
-
-  uint8_t payload[pollResponse.msgLen];
-  pollResponse.payload = payload;
+/**
+ * @brief Full-duplex burst state shared by all reads.
+ *
+ * tx stays filled with 0xFF (the idle byte) between bursts. Command bytes are
+ * copied over the front of it for one burst and only those bytes are reset,
+ * so there is no per-burst memset. Received bytes not yet parsed stay in rx for
+ * the next read, because a frame can complete part way through a burst.
+ */
+typedef struct spiBurst {
+  uint8_t tx[GPS_SPI_BURST_MAX];
+  uint8_t rx[GPS_SPI_BURST_MAX];
+  uint32_t rxLen;
+  uint32_t rxPos;
+  uint8_t cmd[GPS_COMMAND_MAX_FRAME];  // command currently being spliced
+  uint16_t cmdLen;
+  uint16_t cmdPos;
+  bool txReady;
+} spiBurst;
+
+static spiBurst burst = { .txReady = false };
 
-  memset(pollResponse.payload, 0xFF, pollResponse.msgLen);
-  bcm2835_spi_transfern((char *)pollResponse.payload, pollResponse.msgLen);
+/**
+ * @brief Chooses how many bytes to clock in the next burst.
+ *
+ * Mid-payload the rest of the frame is known, so it is fetched in one go;
+ * otherwise a short burst scans for the next sync header.
+ */
+static uint32_t burstLength() {
+  uint32_t len = GPS_SPI_BURST;
+  if (rxParser.state == PARSE_PAYLOAD) {
+    len = (uint32_t)(rxParser.frame.msgLen - rxParser.pos) + 2;
+  }
+  uint32_t cmdRemaining = burst.cmdLen - burst.cmdPos;
+  if (cmdRemaining > len) len = cmdRemaining;
+  if (len < GPS_SPI_BURST) len = GPS_SPI_BURST;
+  if (len > GPS_SPI_BURST_MAX) len = GPS_SPI_BURST_MAX;
+  return len;
+}
 
-  pollResponse.ck_a = bcm2835_spi_transfer(0xFF);
-  pollResponse.ck_b = bcm2835_spi_transfer(0xFF);
+/**
+ * @brief Copies pending command bytes over the front of the TX buffer.
+ *
+ * Commands are taken from the queue back to back until the burst is full; a
+ * command longer than the space left continues in the next burst.
+ *
+ * @return uint32_t Number of TX bytes overwritten
+ */
+static uint32_t spliceCommands(uint32_t len) {
+  uint32_t pos = 0;
+  while (pos < len) {
+    if (burst.cmdPos == burst.cmdLen) {
+      burst.cmdLen = gpsCommandNextToSend(burst.cmd, sizeof(burst.cmd));
+      burst.cmdPos = 0;
+      if (burst.cmdLen == 0) break;
+    }
+    uint32_t n = burst.cmdLen - burst.cmdPos;
+    if (n > len - pos) n = len - pos;
+    memcpy(&burst.tx[pos], &burst.cmd[burst.cmdPos], n);
+    burst.cmdPos += n;
+    pos += n;
+  }
+  return pos;
+}
 
-  printf("Received poll response: class=0x%02X id=0x%02X len=%d\n",
-    pollResponse.msgCls, pollResponse.msgID, pollResponse.msgLen);
+/**
+ * @brief Runs one full-duplex burst: commands out, receiver bytes in.
+ */
+static void runBurst() {
+  if (!burst.txReady) {
+    memset(burst.tx, 0xFF, sizeof(burst.tx));
+    burst.txReady = true;
+  }
+  uint32_t len = burstLength();
+  uint32_t spliced = spliceCommands(len);
+  transportTransfernb(burst.tx, burst.rx, len);
+  if (spliced > 0) memset(burst.tx, 0xFF, spliced);
+  burst.rxLen = len;
+  burst.rxPos = 0;
+}
 
-  if (pollResponse.msgCls == 0x06 && pollResponse.msgID == 0x01) {
-    checkConfigMsgSettings(pollResponse.payload);
-  } else if (pollResponse.msgCls == 0x06 && pollResponse.msgID == 0x08) {
-    checkRateSettings(pollResponse.payload);
-  } else {
-    printf("Unrecognized poll response: class=0x%02X id=0x%02X\n",
-            pollResponse.msgCls, pollResponse.msgID);
+/**
+ * @brief Parses received bytes until a valid frame completes, the deadline passes,
+ *        or maxIdleBytes have gone by without a frame starting.
+ *
+ * Bytes are clocked in bursts of GPS_SPI_BURST or more, with any queued commands
+ * riding on the outgoing side, and the deadline is checked once per burst.
+ *
+ * @param deadlineUs perfNowUs() deadline, or 0 for none
+ * @param maxIdleBytes Bytes tolerated while hunting for a sync header, or 0 for no limit
+ * @return const incomingUBX* Frame valid until the next read, or NULL
+ */
+static const incomingUBX *readFrame(int64_t deadlineUs, uint32_t maxIdleBytes) {
+  uint32_t idle = 0;
+  while (1) {
+    while (burst.rxPos < burst.rxLen) {
+      uint8_t b = burst.rx[burst.rxPos++];
+      int status = ubxParserFeed(&rxParser, b);
+      if (status == 1) return &rxParser.frame;
+
+      // Any byte that leaves the parser hunting counts: idle 0xFF, a bus stuck
+      // at 0x00 and noise must all end a bounded scan
+      if (rxParser.state == PARSE_SYNC1) {
+        if (maxIdleBytes > 0 && ++idle >= maxIdleBytes) return NULL;
+      } else {
+        idle = 0;
+      }
+    }
+    if (deadlineUs > 0 && perfNowUs() >= deadlineUs) return NULL;
+    runBurst();
   }
 }
 
+/**
+ * @brief Reads the next valid UBX frame, giving up after timeoutMs.
+ *
+ * @param timeoutMs Maximum time to wait for a complete frame
+ * @return const incomingUBX* Frame valid until the next read, or NULL on timeout
+ */
+const incomingUBX *readUBX(uint32_t timeoutMs) {
+  return readFrame(perfNowUs() + (int64_t)timeoutMs * 1000, 0);
+}
+
+/**
+ * @brief Reads a UBX frame if one starts within the idle budget.
+ *
+ * The receiver clocks out 0xFF while it has nothing queued, so a bounded scan
+ * lets callers on the GTK thread check for data without blocking. Every byte
+ * scanned outside a frame counts, whatever its value.
+ *
+ * @param maxIdleBytes Number of idle bytes to scan for the sync header
+ * @return const incomingUBX* Frame valid until the next read, or NULL
+ */
+const incomingUBX *tryReadUBX(uint32_t maxIdleBytes) {
+  return readFrame(0, maxIdleBytes);
+}
+
+//////////////// READING MESSAGES //////////////////
+
 /**
  * @brief Decodes the CFG-RATE payload to print measurement and navigation rates.
  */
@@ -210,104 +487,267 @@ void checkConfigMsgSettings(uint8_t *payload) {
   }
 }
 
+//////////////// WATCHDOG //////////////////
+
+static atomic_int healthState = GPS_HEALTH_STARTING;
+static int64_t lastEpochUs = 0;    // last valid NAV-PVT (or reader start)
+static int64_t faultStartUs = 0;   // first missed epoch deadline of the current outage
+static int missedEpochs = 0;
+static int lastReconfigureEpoch = 0;   // missedEpochs when the configuration was last resent
+static atomic_ulong reconfigurations;
+
 /**
- * @brief Reads an ACK or NACK UBX response following a configuration command.
- *
- * Matches expected response class (0x05) and determines ACK/NACK status
- * based on the message ID and payload.
+ * @brief Human readable name of a health state.
  */
-void readACKResponse(const char *label) {
-  uint16_t header = 0xFFFF;
-  while (header != 0xB562) {
-    header = (header << 8) | bcm2835_spi_transfer(0xFF);
+const char *gpsHealthName(gpsHealth state) {
+  switch (state) {
+    case GPS_HEALTH_STARTING:      return "STARTING";
+    case GPS_HEALTH_OK:            return "OK";
+    case GPS_HEALTH_DEGRADED:      return "DEGRADED";
+    case GPS_HEALTH_LOST:          return "LOST";
+    case GPS_HEALTH_RECONFIGURING: return "RECONFIGURING";
   }
+  return "UNKNOWN";
+}
 
-  uint8_t cls = bcm2835_spi_transfer(0xFF);
-  uint8_t id = bcm2835_spi_transfer(0xFF);
-  uint8_t lenL = bcm2835_spi_transfer(0xFF);
-  uint8_t lenH = bcm2835_spi_transfer(0xFF);
-  uint8_t payload[2] = {0xFF, 0xFF};
+/**
+ * @brief Returns the current receiver health.
+ */
+gpsHealth gpsGetHealth() {
+  return (gpsHealth)atomic_load(&healthState);
+}
+
+/**
+ * @brief Copies the link error counters.
+ */
+void gpsGetLinkStats(gpsLinkStats *stats) {
+  stats->checksumErrors = atomic_load(&checksumErrors);
+  stats->lengthErrors = atomic_load(&lengthErrors);
+  stats->reconfigurations = atomic_load(&reconfigurations);
+}
 
-  if ((lenL | (lenH << 8)) == 2) {
-    bcm2835_spi_transfern((char *)payload, 2);
+/**
+ * @brief Changes health state and publishes it to the GUI.
+ */
+static void setHealth(gpsHealth state, bool onGuiThread) {
+  if (atomic_exchange(&healthState, state) == (int)state) return;
+  printf("GPS health: %s\n", gpsHealthName(state));
+  if (onGuiThread) {
+    updateGPSHealth(GINT_TO_POINTER(state));
+  } else {
+    g_idle_add(updateGPSHealth, GINT_TO_POINTER(state));
   }
+}
 
-  uint8_t ck_a = bcm2835_spi_transfer(0xFF);
-  uint8_t ck_b = bcm2835_spi_transfer(0xFF);
-  (void) ck_a;
-  (void) ck_b;
+/**
+ * @brief Queues the runtime configuration again.
+ *
+ * Used after the receiver has gone silent, e.g. after a brown-out reset wiped
+ * its volatile configuration. The reader sends the commands and matches their ACKs.
+ */
+void reconfigureReceiver() {
+  atomic_fetch_add(&reconfigurations, 1);
+  setProtocol_UBX();
+  setRate_2x1();
+  enable_navPVT();
+}
 
-  if (cls == 0x05 && id == 0x01) {
-    printf("ACK received for %s (cls=0x%02X id=0x%02X)\n", label, payload[0], payload[1]);
-  } else if (cls == 0x05 && id == 0x00) {
-    printf("NACK received for %s (cls=0x%02X id=0x%02X)\n", label, payload[0], payload[1]);
-  } else {
-    printf("Unexpected response after %s: cls=0x%02X id=0x%02X\n", label, cls, id);
+/**
+ * @brief Time without a NAV-PVT after which an epoch counts as missed.
+ *
+ * GPS_EPOCH_TIMEOUT_MS, stretched to 1.5 periods when a slower rate is configured.
+ */
+static int64_t epochTimeoutUs() {
+  int64_t periodUs = (int64_t)gpsCommandEpochPeriodMs() * 1000;
+  int64_t timeoutUs = (int64_t)GPS_EPOCH_TIMEOUT_MS * 1000;
+  return periodUs * 3 / 2 > timeoutUs ? periodUs * 3 / 2 : timeoutUs;
+}
+
+/**
+ * @brief Starts watchdog timing from now.
+ */
+static void watchdogStart() {
+  lastEpochUs = perfNowUs();
+  faultStartUs = 0;
+  missedEpochs = 0;
+  lastReconfigureEpoch = 0;
+}
+
+/**
+ * @brief Records a valid epoch and reports recovery time if an outage just ended.
+ */
+static void watchdogEpochReceived(bool onGuiThread) {
+  int64_t now = perfNowUs();
+  if (faultStartUs > 0) {
+    int64_t recoveryUs = now - faultStartUs;
+    printf("GPS recovered after %.1f ms (%d missed epochs)\n", recoveryUs / 1000.0, missedEpochs);
+    perfNoteRecovery(recoveryUs);
   }
+  faultStartUs = 0;
+  missedEpochs = 0;
+  lastReconfigureEpoch = 0;
+  lastEpochUs = now;
+  setHealth(GPS_HEALTH_OK, onGuiThread);
+}
+
+/**
+ * @brief Counts epochs missed since the last valid one and escalates health.
+ *
+ * Once GPS_RECONFIGURE_AFTER_EPOCHS epochs have been missed since the last
+ * resend the receiver configuration is resent, even if a late check skipped
+ * over the exact multiple.
+ */
+static void watchdogCheck(bool onGuiThread) {
+  int64_t now = perfNowUs();
+  int64_t timeoutUs = epochTimeoutUs();
+  int missed = (int)((now - lastEpochUs) / timeoutUs);
+  if (missed <= missedEpochs) return;
+
+  missedEpochs = missed;
+  if (faultStartUs == 0) faultStartUs = lastEpochUs + timeoutUs;
+
+  if (missed - lastReconfigureEpoch >= GPS_RECONFIGURE_AFTER_EPOCHS) {
+    lastReconfigureEpoch = missed;
+    setHealth(GPS_HEALTH_RECONFIGURING, onGuiThread);
+    printf("GPS silent for %d epochs, reconfiguring receiver\n", missed);
+    reconfigureReceiver();
+  }
+  setHealth(missed >= GPS_RECONFIGURE_AFTER_EPOCHS ? GPS_HEALTH_LOST : GPS_HEALTH_DEGRADED, onGuiThread);
 }
 
 //////////////// GPS START //////////////////
 
+// Buffer the reader fills next; flips after every NAV-PVT so the GUI keeps the other one
+static bool readerFillsFront = true;
+
+/**
+ * @brief Reads one UBX frame and, for NAV-PVT, copies it into the inactive buffer.
+ *
+ * Queued commands go out spliced into the read bursts, and ACK/NACK or poll
+ * responses are handed to the command queue. Frames are parsed into a private staging buffer, so
+ * bufferLock is only held for the copy and never while waiting on the receiver.
+ *
+ * @param buffers Shared front/back buffers
+ * @param deadlineUs Read deadline (perfNowUs), or 0 for none
+ * @param maxIdleBytes Idle bytes to scan before giving up, or 0 for no limit
+ * @param publishFront Set to the buffer flag the GUI should read when a NAV-PVT arrives
+ * @return int 1 if a NAV-PVT frame is ready to publish, 0 if another frame was read,
+ *             -1 if nothing arrived in time
+ */
+static int gpsReadFrame(bufferStruct *buffers, int64_t deadlineUs, uint32_t maxIdleBytes, bool *publishFront) {
+  gpsCommandExpire();
+  const incomingUBX *frame = readFrame(deadlineUs, maxIdleBytes);
+  if (!frame) return -1;
+  if (gpsCommandHandleFrame(frame)) return 0;
+  if (frame->msgCls != 0x01 || frame->msgID != 0x07 || frame->msgLen != sizeof(navpvt_data)) return 0;
+
+  perfNoteFrameRead();
+  bool fillFront = readerFillsFront;
+  incomingUBX *target = fillFront ? buffers->fBuffer : buffers->bBuffer;
+
+  pthread_mutex_lock(&buffers->bufferLock);
+  target->sync1 = frame->sync1;
+  target->sync2 = frame->sync2;
+  target->msgCls = frame->msgCls;
+  target->msgID = frame->msgID;
+  target->msgLen = frame->msgLen;
+  memcpy(target->payload, frame->payload, frame->msgLen);
+  target->ck_a = frame->ck_a;
+  target->ck_b = frame->ck_b;
+  pthread_mutex_unlock(&buffers->bufferLock);
+
+  navpvt_data *navpvt = (navpvt_data *)target->payload;
+  printf("LAT: %d, LON: %d\n", navpvt->lat, navpvt->lon);
+
+  readerFillsFront = !fillFront;
+  *publishFront = fillFront;
+  return 1;
+}
+
+/**
+ * @brief Sleeps until shortly before the next epoch, waking early for queued commands.
+ */
+static void waitForNextEpoch() {
+  // Commands still queued or awaiting their ACK are serviced by reading on
+  if (gpsCommandPending() > 0) return;
+
+  struct pollfd pfd = { .fd = gpsCommandFd(), .events = POLLIN };
+  int timeoutMs = (int)(gpsCommandEpochPeriodMs() * 9 / 10);
+  if (pfd.fd < 0) {
+    usleep(timeoutMs * 1000);
+    return;
+  }
+  if (poll(&pfd, 1, timeoutMs) > 0) gpsCommandDrainFd();
+}
+
 /**
  * @brief GPS reader thread entry point.
  *
  * Continuously reads NAV-PVT messages into double-buffered memory.
  * Alternates front/back buffers, prints latitude/longitude,
  * and schedules GUI label updates using GLib idle callbacks.
+ * Each epoch read has a deadline; missed epochs drive the watchdog.
+ * Between epochs the thread sleeps for most of the configured period, and
+ * queued commands wake it so they are sent without waiting for the next epoch.
  *
  * @param arg Pointer to bufferStruct used for synchronization and data sharing
  * @return NULL
  */
 void *startGPS(void *arg) {
   bufferStruct *buffers = (bufferStruct *)arg;
-  incomingUBX *currentBuffer = buffers->fBuffer;
-  navpvt_data *navpvt;
   gpsRunning = buffers->isRunning;
-  
-  atomic_bool useFrontBuffer = ATOMIC_VAR_INIT(true);
+  perfRegisterReader();
+  watchdogStart();
+
   while(atomic_load(gpsRunning)) {
-    pthread_mutex_lock(&buffers->bufferLock);
-    readUBX(currentBuffer);
-    pthread_mutex_unlock(&buffers->bufferLock);
-    navpvt = (navpvt_data*)currentBuffer->payload;
-    printf("LAT: %d, LON: %d\n", navpvt->lat, navpvt->lon);
-    if(atomic_load(&useFrontBuffer)) {
-      currentBuffer = buffers->bBuffer;
-      atomic_store(&useFrontBuffer, false);
+    bool publishFront;
+    int64_t deadline = perfNowUs() + epochTimeoutUs();
+    int status = 0;
+    while (status == 0) {
+      status = gpsReadFrame(buffers, deadline, 0, &publishFront);
+    }
+    if (status == 1) {
+      watchdogEpochReceived(false);
+      g_idle_add(updateGPSLabels, GINT_TO_POINTER(publishFront));
+      waitForNextEpoch();
     } else {
-      currentBuffer = buffers->fBuffer;
-      atomic_store(&useFrontBuffer, true);
+      watchdogCheck(false);
     }
-    g_idle_add(updateGPSLabels, GINT_TO_POINTER(atomic_load(&useFrontBuffer)));
-    usleep(900000);
   }
   printf("Value of atomic boolean: %s\n", atomic_load(gpsRunning) ? "true" : "false");
   return NULL;
 }
 
 /**
- * @brief Reads a UBX message from the GPS module.
+ * @brief Drains pending frames without blocking, for use on the GTK main thread.
  *
- * This version is simplified for NAV-PVT messages only.
- * Reads header, class, ID, length, payload, and checksum.
+ * Called by the single-threaded event loop when the transport, poll timer or
+ * command queue fires.
+ * Each NAV-PVT read is published to the GUI directly since no thread hop is needed.
  *
- * @param msg Pointer to an incomingUBX struct to be populated
+ * @param buffers Shared front/back buffers
+ * @return int Number of NAV-PVT frames published
  */
-void readUBX(incomingUBX *msg) {
-  uint16_t header = 0xFFFF;
-  while(header != 0xB562) {
-    header = (header << 8) | bcm2835_spi_transfer(0xFF);
+int gpsPollFrames(bufferStruct *buffers) {
+  static bool watchdogStarted = false;
+  if (!watchdogStarted) {
+    watchdogStart();
+    watchdogStarted = true;
   }
 
-  msg->msgCls = bcm2835_spi_transfer(0xFF);
-  msg->msgID = bcm2835_spi_transfer(0xFF);
-  msg->msgLen = bcm2835_spi_transfer(0xFF);
-  msg->msgLen |= bcm2835_spi_transfer(0xFF) << 8;
-  printf("UBX msg received: class=0x%02X id=0x%02X len=%d\n", msg->msgCls, msg->msgID, msg->msgLen);
-
-  memset(msg->payload, 0xFF, msg->msgLen);
-  bcm2835_spi_transfern((char *) msg->payload, msg->msgLen);
-
-  msg->ck_a = bcm2835_spi_transfer(0xFF);
-  msg->ck_b = bcm2835_spi_transfer(0xFF);
+  // Noise that keeps half-forming frames would otherwise never exhaust the idle budget
+  int64_t deadlineUs = perfNowUs() + GPS_POLL_BUDGET_MS * 1000;
+  int published = 0;
+  for (int i = 0; i < GPS_MAX_FRAMES_PER_POLL; i++) {
+    bool publishFront;
+    int status = gpsReadFrame(buffers, deadlineUs, GPS_IDLE_SCAN_BYTES, &publishFront);
+    if (status < 0) break;
+    if (status == 1) {
+      watchdogEpochReceived(true);
+      updateGPSLabels(GINT_TO_POINTER(publishFront));
+      published++;
+    }
+  }
+  if (published == 0) watchdogCheck(true);
+  return published;
 }
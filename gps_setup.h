@@ -12,7 +12,9 @@
  *              - `bufferStruct`: Thread-safe container for front/back GPS data buffers.
  *
  *              The declared functions support polling GPS configuration, sending setup commands,
- *              parsing UBX responses, and running GPS readout in a background thread.
+ *              parsing UBX responses, and running GPS readout either in a background thread
+ *              or non-blocking from the GTK main loop. All reads are deadline-bounded and a
+ *              watchdog tracks receiver health (`gpsHealth`).
  *
  * @license     MIT License
  *              Copyright (c) 2025 Joshua Anselm
@@ -40,12 +42,32 @@
 #define GPS_SETUP_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdatomic.h>
 #include <pthread.h>  
 
+// Largest UBX payload the reader accepts; longer frames are treated as desync
+#define GPS_MAX_PAYLOAD 512
+// A NAV-PVT epoch not seen within this window counts as missed
+#define GPS_EPOCH_TIMEOUT_MS 1500
+// Time allowed for a queued command's poll response or ACK/NACK
+#define GPS_RESPONSE_TIMEOUT_MS 1000
+// Consecutive missed epochs before the receiver configuration is resent
+#define GPS_RECONFIGURE_AFTER_EPOCHS 3
+// Bytes scanned for a sync header before a non-blocking read gives up
+#define GPS_IDLE_SCAN_BYTES 64
+// Longest a non-blocking drain may keep the GTK thread reading, however the bus behaves
+#define GPS_POLL_BUDGET_MS 5
+// Bytes clocked per full-duplex read burst while hunting for a frame
+#define GPS_SPI_BURST 32
+// Largest single burst (the remainder of a NAV-PVT fits comfortably)
+#define GPS_SPI_BURST_MAX 256
+// Upper bound on frames drained per event loop dispatch
+#define GPS_MAX_FRAMES_PER_POLL 8
+
 /**
  * @brief NAV-PVT data structure as defined by the UBX protocol.
  *
@@ -155,6 +177,26 @@ typedef struct bufferStruct {
   pthread_mutex_t bufferLock;   
 } bufferStruct;
 
+/**
+ * @brief Receiver health as tracked by the reader watchdog.
+ */
+typedef enum gpsHealth {
+  GPS_HEALTH_STARTING,      // no valid epoch received yet
+  GPS_HEALTH_OK,            // epochs arriving on time
+  GPS_HEALTH_DEGRADED,      // one or more epochs missed
+  GPS_HEALTH_LOST,          // GPS_RECONFIGURE_AFTER_EPOCHS or more epochs missed
+  GPS_HEALTH_RECONFIGURING  // configuration being resent
+} gpsHealth;
+
+/**
+ * @brief Link error counters since startup.
+ */
+typedef struct gpsLinkStats {
+  unsigned long checksumErrors;
+  unsigned long lengthErrors;
+  unsigned long reconfigurations;
+} gpsLinkStats;
+
 // Function declarations for polling, configuration, reading, and threading
 
 void pollConfig();
@@ -165,11 +207,16 @@ void setProtocol_UBX();
 void enable_navPVT();
 void setRate_4x2();
 void setRate_2x1();
-void readUBX(incomingUBX *msg);
+const incomingUBX *readUBX(uint32_t timeoutMs);
+const incomingUBX *tryReadUBX(uint32_t maxIdleBytes);
 void *startGPS(void *arg);
-void readPollResponse();
+int gpsPollFrames(bufferStruct *buffers);
+void calculateUBXChecksum(const uint8_t *msg, uint16_t length, uint8_t *ck_a, uint8_t *ck_b);
 void checkRateSettings(uint8_t *payload);
 void checkConfigMsgSettings(uint8_t *payload);
-void readACKResponse(const char *label);
+void reconfigureReceiver();
+gpsHealth gpsGetHealth();
+const char *gpsHealthName(gpsHealth state);
+void gpsGetLinkStats(gpsLinkStats *stats);
 
 #endif
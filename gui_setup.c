@@ -39,25 +39,43 @@
 
  #include "gui_setup.h"
  #include "gps_setup.h"
+ #include "gps_command.h"
+ #include "perf_stats.h"
+ #include "worker_pool.h"
+ #include "map_cache.h"
+ #include "tile_engine.h"
+ #include "icon_atlas.h"
+ #include "map_projection.h"
+ #include "map_catalog.h"
+ #include "track_overlay.h"
+ #include "dead_reckon.h"
+ #include "dashboard_model.h"
+ #include "perf_hud.h"
+ #include "fb_backend.h"
+ #include "compositor.h"
+ #include "camera_follow.h"
+ #include "speed_gauge.h"
  #include <stdio.h>
  #include <stdlib.h>
  #include <unistd.h>
  #include <string.h>
- #include <bcm2835.h>
  #include <arpa/inet.h>
  #include <gtk/gtk.h>
+ #include <glib-unix.h>
+ #include <signal.h>
  #include <time.h>
  #include <stdbool.h>
  #include <stdatomic.h>
+ #include <math.h>
  
  // Struct of GUI elements
  typedef struct {
    GtkWidget *window;
-   GtkWidget *latitudeLabel;
-   GtkWidget *longitudeLabel;
    GtkWidget *timeLabel;
-   GtkWidget *speedLabel;
+   GtkWidget *healthLabel;
+   GtkWidget *speedGauge;
    GtkWidget *timeZoneDropdown;
+   GtkWidget *rateDropdown;
    GtkWidget *closeButton;
    GtkWidget *leftLabel;
    GtkWidget *primaryAirLabel;
@@ -85,11 +103,91 @@
  static bool isPrimaryPressureOK = false;
  static bool isSecondaryPressureOK = false;
  
- // Map bounding box (hardcoded to test image)
- #define MAP_LAT_TOP     // lat top val
- #define MAP_LAT_BOTTOM  // lat bottom val
- #define MAP_LON_LEFT   // lon val
- #define MAP_LON_RIGHT  // lon val
+ // Map area size until a map from the catalogue (map_catalog.h) is shown
+ #define MAP_IMAGE_WIDTH 2053
+ #define MAP_IMAGE_HEIGHT 1368
+ 
+ // Frames rendered per second without GTK (headless or framebuffer)
+ #define OFFSCREEN_FPS 30
+ // Longest wait for the first map decode before headless frames are counted anyway
+ #define HEADLESS_MAP_WAIT_MS 10000
+ // Width of the dashboard column beside the map on the framebuffer
+ #define FB_PANEL_WIDTH 200
+ 
+ // Lat/lon to pixel projection of the map image
+ static mapProjection mapProj;
+ 
+ // Catalogue map being shown, decoded into a cairo surface by map_cache.c
+ static const mapCatalogEntry *currentMap = NULL;
+ 
+ // Zoom level used when drawing from a tile source (-1 until a tile source is seen)
+ static int tileZoom = -1;
+ 
+ // Display scale of the single-image map, stepped by a quarter octave per wheel notch
+ #define MAP_ZOOM_MIN 0.125
+ #define MAP_ZOOM_MAX 4.0
+ #define MAP_ZOOM_STEP 1.189207115
+ static double mapZoom = 1.0;
+ 
+ // Scroll position that keeps the zoom anchor still, or centres the marker after a map
+ // switch, applied once the map is resized
+ static bool zoomScrollPending = false;
+ static double zoomScrollX = 0;
+ static double zoomScrollY = 0;
+ 
+ // Pinch-to-zoom on the map and the zoom its current gesture started from
+ static GtkGesture *zoomGesture = NULL;
+ static double gestureStartZoom = 1.0;
+ static int gestureStartTileZoom = 0;
+ 
+ // Marker box last queued for drawing, so a move repaints only the old and new boxes
+ static GdkRectangle markerRect;
+ static bool markerQueued = false;
+ 
+ // Marker position, extrapolated between fixes on the frame clock
+ static deadReckoner markerMotion;
+ static mapCoord shownFix;
+ static guint markerTickId = 0;
+ 
+ // Scroll position of the single-image map, eased after the marker on the frame clock
+ static followCamera camera;
+ static guint cameraTickId = 0;
+ 
+ // Formatted label texts, pushed to GTK only when they change
+ static dashboardModel dashboard;
+ 
+ // Speedometer and its needle animation on the gauge's frame clock
+ static speedGauge gauge;
+ static guint gaugeTickId = 0;
+ 
+ // Performance HUD refresh timer and the box it was last queued at (map widget pixels)
+ static guint hudTimerId = 0;
+ static GdkRectangle hudRect;
+ static bool hudQueued = false;
+ 
+ // View the layers were last placed for, and the marker box within it
+ static GdkRectangle layerView;
+ static GdkRectangle layerMarker;
+ 
+ // Something changed since the last offscreen (framebuffer) frame
+ static bool offscreenDirty = true;
+ 
+ // Tile view centre (global pixels) and zoom last queued for drawing
+ static int tileViewX = -1;
+ static int tileViewY = -1;
+ static int tileViewZoom = -1;
+ 
+ /**
+  * @brief Shows the green or red light on a pressure indicator.
+  *
+  * Icons come pre-scaled from the atlas, so this only swaps a reference,
+  * and not even that when the light already shows the right colour.
+  */
+ static void setPressureLight(GtkWidget *image, bool ok) {
+   GdkPixbuf *icon = iconAtlasPixbuf(ok ? ICON_LIGHT_GREEN : ICON_LIGHT_RED);
+   if (gtk_image_get_pixbuf(GTK_IMAGE(image)) == icon) return;
+   gtk_image_set_from_pixbuf(GTK_IMAGE(image), icon);
+ }
  
  /**
   * @brief Updates GUI pressure indicators with colored icons.
@@ -97,20 +195,25 @@
   * Called via idle handler to avoid concurrency issues with GTK.
   */
  gboolean updatePressureDisplay(gpointer data) {
-   const char *primaryImage = isPrimaryPressureOK ? "green_circle.png" : "red_circle.png";
-   const char *secondaryImage = isSecondaryPressureOK ? "green_circle.png" : "red_circle.png";
- 
-   GdkPixbuf *pix = gdk_pixbuf_new_from_file_at_scale(primaryImage, 50, 50, TRUE, NULL);
-   gtk_image_set_from_pixbuf(GTK_IMAGE(guiWindow.primaryAirCircle), pix);
-   g_object_unref(pix);
- 
-   pix = gdk_pixbuf_new_from_file_at_scale(secondaryImage, 50, 50, TRUE, NULL);
-   gtk_image_set_from_pixbuf(GTK_IMAGE(guiWindow.secondaryAirCircle), pix);
-   g_object_unref(pix);
- 
+   if (!guiWindow.primaryAirCircle) {
+     offscreenDirty = true;
+     return G_SOURCE_REMOVE;
+   }
+   setPressureLight(guiWindow.primaryAirCircle, isPrimaryPressureOK);
+   setPressureLight(guiWindow.secondaryAirCircle, isSecondaryPressureOK);
    return G_SOURCE_REMOVE;
  }
  
+ /**
+  * @brief Advances the simulated tank pressure by one step.
+  *
+  * Shared by the pressure thread and the single-threaded event loop.
+  */
+ void stepPressureSimulation() {
+   isPrimaryPressureOK = !isPrimaryPressureOK;
+   isSecondaryPressureOK = !isSecondaryPressureOK;
+ }
+ 
  /**
   * @brief Background thread simulating air tank pressure state changes.
   *
@@ -118,10 +221,9 @@
   */
  void *simulatePressure(void *arg) {
    while (atomic_load(guiRunning)) {
-     isPrimaryPressureOK = !isPrimaryPressureOK;
-     isSecondaryPressureOK = !isSecondaryPressureOK;
+     stepPressureSimulation();
      g_idle_add(updatePressureDisplay, NULL);
-     sleep(3);
+     sleep(PRESSURE_PERIOD_S);
    }
    return NULL;
  }
@@ -151,6 +253,26 @@
    }
  }
  
+ /**
+  * @brief Callback for the update rate dropdown.
+  *
+  * Queues a CFG-RATE change; the receiver keeps streaming while it is applied
+  * and the reader picks up the new period once the change is ACKed.
+  */
+ void on_rate_changed(GtkComboBox *widget, gpointer data) {
+   gchar *selectedRate = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(widget));
+   if (selectedRate != NULL) {
+     if (strcmp(selectedRate, "1 Hz") == 0) {
+       gpsSetRate(500, 2, NULL, NULL);
+     } else if (strcmp(selectedRate, "2 Hz") == 0) {
+       gpsSetRate(250, 2, NULL, NULL);
+     } else if (strcmp(selectedRate, "5 Hz") == 0) {
+       gpsSetRate(200, 1, NULL, NULL);
+     }
+     g_free(selectedRate);
+   }
+ }
+ 
  /**
   * @brief Callback for the CLOSE button. Signals termination and quits GTK loop.
   */
@@ -168,19 +290,12 @@
  gboolean on_circle_clicked(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
    static bool isPrimaryRed = true;
    static bool isSecondaryRed = true;
-   GdkPixbuf *pixbuf;
  
    if (widget == guiWindow.primaryAirCircle) {
-     pixbuf = gdk_pixbuf_new_from_file_at_scale(
-         isPrimaryRed ? "green_circle.png" : "red_circle.png", 50, 50, TRUE, NULL);
-     gtk_image_set_from_pixbuf(GTK_IMAGE(guiWindow.primaryAirCircle), pixbuf);
-     g_object_unref(pixbuf);
+     setPressureLight(guiWindow.primaryAirCircle, isPrimaryRed);
      isPrimaryRed = !isPrimaryRed;
    } else if (widget == guiWindow.secondaryAirCircle) {
-     pixbuf = gdk_pixbuf_new_from_file_at_scale(
-         isSecondaryRed ? "green_circle.png" : "red_circle.png", 50, 50, TRUE, NULL);
-     gtk_image_set_from_pixbuf(GTK_IMAGE(guiWindow.secondaryAirCircle), pixbuf);
-     g_object_unref(pixbuf);
+     setPressureLight(guiWindow.secondaryAirCircle, isSecondaryRed);
      isSecondaryRed = !isSecondaryRed;
    }
  
@@ -188,38 +303,632 @@
  }
  
  /**
-  * @brief Draws background map image and overlays a GPS marker based on position.
+  * @brief Repaints the map once the cached surface has been (re)decoded, or a
+  *        tile has arrived from the worker pool.
+  */
+ static void onMapReady(void *data) {
+   compositorDamage(LAYER_MAP, NULL);
+   if (guiWindow.mapArea) gtk_widget_queue_draw(guiWindow.mapArea);
+   else offscreenDirty = true;
+ }
+ 
+ /**
+  * @brief Queues part of the map for recompositing. Without GTK (headless or
+  *        framebuffer) whole frames are rendered, so it only flags a change.
   *
-  * Called automatically by GTK when drawing area needs repainting.
+  * Layers whose content changed must be damaged as well (compositorDamage).
   */
- gboolean draw_map_and_marker(GtkWidget *widget, cairo_t *cr, gpointer data) {
-   GdkPixbuf *map = gdk_pixbuf_new_from_file("testMap.png", NULL);
-   if (!map) return FALSE;
-   gdk_cairo_set_source_pixbuf(cr, map, 0, 0);
-   cairo_paint(cr);
-   g_object_unref(map);
+ static void damageMapArea(int x, int y, int width, int height) {
+   if (guiWindow.mapArea) gtk_widget_queue_draw_area(guiWindow.mapArea, x, y, width, height);
+   else offscreenDirty = true;
+ }
+ 
+ /**
+  * @brief Repaints every layer and the whole map (see damageMapArea).
+  */
+ static void damageMap() {
+   compositorDamageAll();
+   if (guiWindow.mapArea) gtk_widget_queue_draw(guiWindow.mapArea);
+   else offscreenDirty = true;
+ }
+ 
+ /**
+  * @brief Bounding box of the location marker with its tip at (x, y).
+  */
+ static GdkRectangle markerBounds(int x, int y) {
+   GdkRectangle rect = {x - ICON_MARKER_SIZE / 2, y - ICON_MARKER_SIZE, ICON_MARKER_SIZE, ICON_MARKER_SIZE};
+   return rect;
+ }
+ 
+ /**
+  * @brief Position of the marker on the single-image map, in whole widget
+  *        pixels at the current zoom.
+  *
+  * @return bool False if there is no fix yet or the map is not georeferenced
+  */
+ static bool imageMarkerPosition(int *x, int *y) {
+   if (!markerMotion.valid || !mapProjectionValid(&mapProj)) return false;
+   mapPoint point = mapProject(&mapProj, shownFix);
+   *x = (int)floor(point.x * mapZoom / MAP_FIXED_ONE);
+   *y = (int)floor(point.y * mapZoom / MAP_FIXED_ONE);
+   return true;
+ }
+ 
+ /**
+  * @brief Global pixel at the centre of the tile view: the marker, or the tile
+  *        pack's own centre before the first fix.
+  */
+ static void tileViewCenter(double *centerX, double *centerY) {
+   if (tileZoom < 0) tileZoom = tileEngineMaxZoom();
+   double lat = 0, lon = 0;
+   if (markerMotion.valid) {
+     lat = shownFix.latE7 / 1e7;
+     lon = shownFix.lonE7 / 1e7;
+   } else {
+     tileEngineDefaultCenter(&lat, &lon);
+   }
+   tileEngineProject(lat, lon, tileZoom, centerX, centerY);
+ }
+ 
+ /**
+  * @brief Total area of the region a draw call was asked to repaint.
+  */
+ static uint64_t clipArea(cairo_t *cr) {
+   cairo_rectangle_list_t *rects = cairo_copy_clip_rectangle_list(cr);
+   uint64_t area = 0;
+   if (rects->status == CAIRO_STATUS_SUCCESS) {
+     for (int i = 0; i < rects->num_rectangles; i++) {
+       area += (uint64_t)(rects->rectangles[i].width * rects->rectangles[i].height);
+     }
+   }
+   cairo_rectangle_list_destroy(rects);
+   return area;
+ }
+ 
+ /**
+  * @brief Invalidates only the parts of the map a marker move changes.
+  *
+  * On the single-image map that is the marker's old and new boxes, recomposited
+  * from the cached map and track. The tile view is centred on the marker, so
+  * it is repainted whole, but only when the marker has moved by at least a pixel.
+  */
+ static void queueMarkerDamage() {
+   if (tileEngineActive()) {
+     double centerX, centerY;
+     tileViewCenter(&centerX, &centerY);
+     int viewX = (int)floor(centerX);
+     int viewY = (int)floor(centerY);
+     if (viewX == tileViewX && viewY == tileViewY && tileZoom == tileViewZoom) return;
+     tileViewX = viewX;
+     tileViewY = viewY;
+     tileViewZoom = tileZoom;
+     damageMap();
+     return;
+   }
+ 
+   int x, y;
+   if (!imageMarkerPosition(&x, &y)) return;
+   GdkRectangle next = markerBounds(x, y);
+   if (markerQueued && gdk_rectangle_equal(&next, &markerRect)) return;
+   if (markerQueued) {
+     damageMapArea(markerRect.x, markerRect.y, markerRect.width, markerRect.height);
+   }
+   damageMapArea(next.x, next.y, next.width, next.height);
+   markerRect = next;
+   markerQueued = true;
+ }
+ 
+ /**
+  * @brief Frame clock callback: eases the scrolled window towards the camera target.
+  *
+  * Scroll positions are whole pixels, so the cached layers shift without resampling.
+  */
+ static gboolean onCameraTick(GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) {
+   bool moving = cameraStep(&camera, gdk_frame_clock_get_frame_time(frameClock));
+   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   gtk_adjustment_set_value(h_adj, round(camera.x));
+   gtk_adjustment_set_value(v_adj, round(camera.y));
+   if (moving) return G_SOURCE_CONTINUE;
+   cameraTickId = 0;
+   return G_SOURCE_REMOVE;
+ }
+ 
+ /**
+  * @brief Keeps the marker in view on the single-image map.
+  *
+  * The view only scrolls once the marker leaves the camera's dead zone, and
+  * then eases on the frame clock. While the camera is idle it takes up the
+  * current scroll position, so manual scrolling and zooming are kept.
+  */
+ static void followMarker(int64_t nowUs) {
+   int x, y;
+   if (!guiWindow.scrollWindow || tileEngineActive() || !imageMarkerPosition(&x, &y)) return;
+ 
+   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   if (camera.placed && !camera.moving) {
+     cameraReset(&camera, gtk_adjustment_get_value(h_adj), gtk_adjustment_get_value(v_adj));
+   }
+   bool wasPlaced = camera.placed;
+   bool moving = cameraFollow(&camera, x, y, gtk_adjustment_get_page_size(h_adj), gtk_adjustment_get_page_size(v_adj),
+                              gtk_adjustment_get_upper(h_adj), gtk_adjustment_get_upper(v_adj), nowUs);
+   if (!wasPlaced) {
+     // First fix: jump straight to it
+     gtk_adjustment_set_value(h_adj, round(camera.x));
+     gtk_adjustment_set_value(v_adj, round(camera.y));
+   } else if (moving && cameraTickId == 0) {
+     cameraTickId = gtk_widget_add_tick_callback(guiWindow.mapArea, onCameraTick, NULL, NULL);
+   }
+ }
+ 
+ /**
+  * @brief Frame clock callback: moves the marker along the extrapolated path.
+  *
+  * Runs only while the marker is moving, so a parked vehicle costs no frames.
+  */
+ static gboolean onMarkerTick(GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) {
+   int64_t now = gdk_frame_clock_get_frame_time(frameClock);
+   shownFix = deadReckonPosition(&markerMotion, now);
+   queueMarkerDamage();
+   followMarker(now);
+   if (deadReckonMoving(&markerMotion, now)) return G_SOURCE_CONTINUE;
+   markerTickId = 0;
+   return G_SOURCE_REMOVE;
+ }
+ 
+ /**
+  * @brief Takes in a new fix: logs it on the track, restarts the marker's
+  *        extrapolation from it and invalidates what changed.
+  */
+ static void queueMapDamage() {
+   if (!navpvt->flags.bits.gnssFixOK) return;
+   mapCoord fix = {navpvt->lat, navpvt->lon};
+ 
+   if (trackAppend(fix)) {
+     cairo_rectangle_int_t trackDamage;
+     // Read every time, so a trim while on tiles is not reported later
+     bool trimmed = trackImageInvalidated();
+     if (tileEngineActive()) {
+       // Repainted with the next frame, which the view following the fix brings
+       compositorDamage(LAYER_TRACK, NULL);
+     } else if (trimmed) {
+       // The oldest fixes were dropped and the overlay with them: rebuild all of it
+       damageMap();
+     } else if (trackUpdateImage(&mapProj, &trackDamage)) {
+       // Damage is in map pixels; round outwards to widget pixels at the current zoom
+       int x1 = (int)floor(trackDamage.x * mapZoom);
+       int y1 = (int)floor(trackDamage.y * mapZoom);
+       int x2 = (int)ceil((trackDamage.x + trackDamage.width) * mapZoom);
+       int y2 = (int)ceil((trackDamage.y + trackDamage.height) * mapZoom);
+       GdkRectangle rect = {x1, y1, x2 - x1, y2 - y1};
+       compositorDamage(LAYER_TRACK, &rect);
+       damageMapArea(rect.x, rect.y, rect.width, rect.height);
+     }
+   }
  
-   double lat = navpvt->lat / 1e7;
-   double lon = navpvt->lon / 1e7;
+   int64_t now = g_get_monotonic_time();
+   deadReckonFix(&markerMotion, fix, navpvt->velN, navpvt->velE, navpvt->iTOW, now);
+   shownFix = deadReckonPosition(&markerMotion, now);
+   queueMarkerDamage();
+   // Headless runs advance the marker once per rendered frame instead
+   if (guiWindow.mapArea && markerTickId == 0 && deadReckonMoving(&markerMotion, now)) {
+     markerTickId = gtk_widget_add_tick_callback(guiWindow.mapArea, onMarkerTick, NULL, NULL);
+   }
+ }
  
-   double x = (lon - MAP_LON_LEFT) / (MAP_LON_RIGHT - MAP_LON_LEFT) * gtk_widget_get_allocated_width(widget);
-   double y = (MAP_LAT_TOP - lat) / (MAP_LAT_TOP - MAP_LAT_BOTTOM) * gtk_widget_get_allocated_height(widget);
+ /**
+  * @brief Size of the single-image map in widget pixels at the current zoom.
+  */
+ static void mapPixelSize(int *width, int *height) {
+   *width = (int)ceil((mapProjectionValid(&mapProj) ? mapProj.width : MAP_IMAGE_WIDTH) * mapZoom);
+   *height = (int)ceil((mapProjectionValid(&mapProj) ? mapProj.height : MAP_IMAGE_HEIGHT) * mapZoom);
+ }
+ 
+ /**
+  * @brief Sizes the map widget to the single-image map at the current zoom.
+  */
+ static void applyMapSize() {
+   int width, height;
+   mapPixelSize(&width, &height);
+   gtk_widget_set_size_request(guiWindow.mapArea, width, height);
+ }
+ 
+ /**
+  * @brief Switches the tile view to another zoom level within the pack's range.
+  */
+ static void setTileZoom(int zoom) {
+   zoom = CLAMP(zoom, tileEngineMinZoom(), tileEngineMaxZoom());
+   if (zoom == tileZoom) return;
+   tileZoom = zoom;
+   queueMarkerDamage();
+ }
+ 
+ /**
+  * @brief Rescales the single-image map, keeping the map point under an anchor still.
+  *
+  * @param zoom New display scale, clamped to MAP_ZOOM_MIN..MAP_ZOOM_MAX
+  * @param anchorX Anchor in map widget coordinates at the old zoom
+  * @param anchorY Anchor in map widget coordinates at the old zoom
+  */
+ static void setMapZoom(double zoom, double anchorX, double anchorY) {
+   zoom = CLAMP(zoom, MAP_ZOOM_MIN, MAP_ZOOM_MAX);
+   if (zoom == mapZoom) return;
  
-   GdkPixbuf *icon = gdk_pixbuf_new_from_file_at_scale("loc_icon.png", 24, 24, TRUE, NULL);
-   if (icon) {
-     gdk_cairo_set_source_pixbuf(cr, icon, x - 12, y - 24);
+   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   double ratio = zoom / mapZoom;
+   // The anchor stays at the same offset from the top left of the viewport
+   zoomScrollX = anchorX * ratio - (anchorX - gtk_adjustment_get_value(h_adj));
+   zoomScrollY = anchorY * ratio - (anchorY - gtk_adjustment_get_value(v_adj));
+   zoomScrollPending = true;
+ 
+   mapZoom = zoom;
+   markerQueued = false;
+   // Targets were at the old scale; the camera takes up the anchored scroll position
+   if (camera.placed) cameraReset(&camera, zoomScrollX, zoomScrollY);
+   applyMapSize();
+   damageMap();
+ }
+ 
+ /**
+  * @brief Switches the single-image map to another catalogue entry.
+  *
+  * The marker lands somewhere else on the new image, so the view is recentred
+  * on it rather than eased there.
+  */
+ static void showMap(const mapCatalogEntry *entry) {
+   if (entry == currentMap) return;
+   currentMap = entry;
+   mapProj = entry->proj;
+   printf("Map: %s\n", entry->imagePath);
+   mapCacheInit(entry->imagePath, onMapReady, NULL);
+   markerQueued = false;
+ 
+   int x, y;
+   if (guiWindow.scrollWindow && imageMarkerPosition(&x, &y)) {
+     GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+     GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+     zoomScrollX = MAX(0, x - gtk_adjustment_get_page_size(h_adj) / 2);
+     zoomScrollY = MAX(0, y - gtk_adjustment_get_page_size(v_adj) / 2);
+     zoomScrollPending = true;
+     cameraReset(&camera, zoomScrollX, zoomScrollY);
+   } else {
+     // Offscreen, or before the first fix: the camera jumps to the marker when it next follows it
+     camera.placed = false;
+   }
+   if (guiWindow.mapArea) applyMapSize();
+   damageMap();
+ }
+ 
+ /**
+  * @brief Shows the catalogue map that best covers the latest fix, and
+  *        preloads the one the vehicle is heading into.
+  */
+ static void selectMap() {
+   if (tileEngineActive() || mapCatalogCount() == 0 || !navpvt->flags.bits.gnssFixOK) return;
+   mapCoord fix = {navpvt->lat, navpvt->lon};
+   const mapCatalogEntry *best = mapCatalogFind(fix, currentMap);
+   // Off every map the last one stays up
+   if (best) showMap(best);
+   const mapCatalogEntry *next = mapCatalogAhead(fix, navpvt->velN, navpvt->velE, currentMap);
+   if (next) mapCachePreload(next->imagePath);
+ }
+ 
+ /**
+  * @brief Applies the scroll position of a zoom once the map has its new size,
+  *        so the adjustments already cover the new range.
+  */
+ void on_map_size_allocate(GtkWidget *widget, GdkRectangle *allocation, gpointer data) {
+   if (!zoomScrollPending) return;
+   zoomScrollPending = false;
+   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   gtk_adjustment_set_value(h_adj, zoomScrollX);
+   gtk_adjustment_set_value(v_adj, zoomScrollY);
+ }
+ 
+ /**
+  * @brief Ctrl+scroll zooms the map about the pointer; plain scrolling still pans.
+  */
+ gboolean on_map_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer data) {
+   if (!(event->state & GDK_CONTROL_MASK)) return FALSE;
+ 
+   double steps = 0;
+   if (event->direction == GDK_SCROLL_UP) steps = 1;
+   else if (event->direction == GDK_SCROLL_DOWN) steps = -1;
+   else if (event->direction == GDK_SCROLL_SMOOTH) steps = -event->delta_y;
+   if (steps == 0) return TRUE;
+ 
+   if (tileEngineActive()) {
+     setTileZoom(tileZoom + (steps > 0 ? 1 : -1));
+   } else {
+     setMapZoom(mapZoom * pow(MAP_ZOOM_STEP, steps), event->x, event->y);
+   }
+   return TRUE;
+ }
+ 
+ /**
+  * @brief Remembers the zoom a pinch starts from; the gesture scale is relative to it.
+  */
+ void on_zoom_gesture_begin(GtkGesture *gesture, GdkEventSequence *sequence, gpointer data) {
+   gestureStartZoom = mapZoom;
+   gestureStartTileZoom = tileZoom;
+ }
+ 
+ /**
+  * @brief Pinch-to-zoom about the centre of the touch points. Tiles change a
+  *        level per doubling of the pinch.
+  */
+ void on_zoom_gesture_scale_changed(GtkGestureZoom *gesture, gdouble scale, gpointer data) {
+   if (tileEngineActive()) {
+     setTileZoom(gestureStartTileZoom + (int)lround(log2(scale)));
+     return;
+   }
+   double x, y;
+   if (!gtk_gesture_get_bounding_box_center(GTK_GESTURE(gesture), &x, &y)) return;
+   setMapZoom(gestureStartZoom * scale, x, y);
+ }
+ 
+ /**
+  * @brief Part of the map widget currently on screen, in map widget pixels.
+  *
+  * The tile view is always exactly the viewport; the image map scrolls.
+  */
+ static GdkRectangle visibleMapArea() {
+   GdkRectangle view = {0, 0, gtk_widget_get_allocated_width(guiWindow.mapArea),
+                        gtk_widget_get_allocated_height(guiWindow.mapArea)};
+   if (tileEngineActive()) return view;
+   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+   view.x = (int)gtk_adjustment_get_value(h_adj);
+   view.y = (int)gtk_adjustment_get_value(v_adj);
+   view.width = (int)gtk_adjustment_get_page_size(h_adj);
+   view.height = (int)gtk_adjustment_get_page_size(v_adj);
+   return view;
+ }
+ 
+ /**
+  * @brief Box of the performance HUD: the top left of the visible part of the map.
+  */
+ static GdkRectangle hudBounds() {
+   GdkRectangle view = visibleMapArea();
+   GdkRectangle rect = {view.x, view.y, PERF_HUD_WIDTH, PERF_HUD_HEIGHT};
+   return rect;
+ }
+ 
+ /**
+  * @brief Repaints the HUD box, and the box it left behind if the view scrolled.
+  */
+ static void queueHudDamage() {
+   if (!guiWindow.mapArea) return;
+   if (hudQueued) damageMapArea(hudRect.x, hudRect.y, hudRect.width, hudRect.height);
+   hudQueued = perfHudVisible();
+   if (!hudQueued) return;
+   hudRect = hudBounds();
+   damageMapArea(hudRect.x, hudRect.y, hudRect.width, hudRect.height);
+ }
+ 
+ /**
+  * @brief Refreshes the HUD figures once per PERF_HUD_REFRESH_MS while it is shown.
+  */
+ static gboolean onHudTimer(gpointer data) {
+   perfHudRefresh();
+   compositorDamage(LAYER_HUD, NULL);
+   queueHudDamage();
+   return G_SOURCE_CONTINUE;
+ }
+ 
+ /**
+  * @brief Shows or hides the performance HUD and its refresh timer.
+  */
+ static void setHudVisible(bool visible) {
+   perfHudSetVisible(visible);
+   if (visible && hudTimerId == 0) {
+     hudTimerId = g_timeout_add(PERF_HUD_REFRESH_MS, onHudTimer, NULL);
+   } else if (!visible && hudTimerId != 0) {
+     g_source_remove(hudTimerId);
+     hudTimerId = 0;
+   }
+   compositorDamage(LAYER_HUD, NULL);
+   queueHudDamage();
+ }
+ 
+ /**
+  * @brief Keeps the HUD pinned to the viewport while the map scrolls under it.
+  */
+ void on_map_scrolled(GtkAdjustment *adjustment, gpointer data) {
+   if (hudQueued) queueHudDamage();
+ }
+ 
+ /**
+  * @brief F3 or H toggles the performance HUD.
+  */
+ gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer data) {
+   if (event->keyval != GDK_KEY_F3 && event->keyval != GDK_KEY_h && event->keyval != GDK_KEY_H) return FALSE;
+   setHudVisible(!perfHudVisible());
+   return TRUE;
+ }
+ 
+ /**
+  * @brief Map layer: the visible tiles, or the cached map image at mapZoom.
+  */
+ static void paintMapLayer(cairo_t *cr, void *data) {
+   if (tileEngineActive()) {
+     double centerX, centerY;
+     tileViewCenter(&centerX, &centerY);
+     tileEngineDraw(cr, layerView.width, layerView.height, centerX, centerY, tileZoom);
+   } else if (!mapCachePaint(cr, mapZoom)) {
+     cairo_set_source_rgb(cr, 0.85, 0.85, 0.85);
      cairo_paint(cr);
-     g_object_unref(icon);
    }
+ }
+ 
+ /**
+  * @brief Track layer: the breadcrumb path over the map.
+  */
+ static void paintTrackLayer(cairo_t *cr, void *data) {
+   if (tileEngineActive()) {
+     double centerX, centerY;
+     tileViewCenter(&centerX, &centerY);
+     trackPaintTiles(cr, tileZoom, floor(centerX - layerView.width / 2.0), floor(centerY - layerView.height / 2.0));
+     return;
+   }
+   cairo_scale(cr, mapZoom, mapZoom);
+   trackPaintImage(cr, &mapProj);
+ }
  
+ /**
+  * @brief Marker layer: the location marker sprite.
+  */
+ static void paintMarkerLayer(cairo_t *cr, void *data) {
+   iconAtlasPaint(cr, ICON_MARKER, layerMarker.x, layerMarker.y);
+ }
+ 
+ /**
+  * @brief HUD layer: the performance HUD, pinned to the top left of the view.
+  */
+ static void paintHudLayer(cairo_t *cr, void *data) {
+   perfHudPaint(cr, layerView.x, layerView.y);
+ }
+ 
+ /**
+  * @brief Sets up the map view layers, bottom to top.
+  */
+ static void initLayers() {
+   compositorInitLayer(LAYER_MAP, CAIRO_FORMAT_RGB24, true, paintMapLayer, NULL);
+   compositorInitLayer(LAYER_TRACK, CAIRO_FORMAT_ARGB32, true, paintTrackLayer, NULL);
+   compositorInitLayer(LAYER_MARKER, CAIRO_FORMAT_ARGB32, false, paintMarkerLayer, NULL);
+   compositorInitLayer(LAYER_HUD, CAIRO_FORMAT_ARGB32, false, paintHudLayer, NULL);
+ }
+ 
+ /**
+  * @brief Moves the layers to the view and the marker, and shows the ones with content.
+  *
+  * The tile view is centred on the marker, so there the marker is in the middle.
+  */
+ static void placeLayers(const GdkRectangle *view) {
+   layerView = *view;
+   compositorPlace(LAYER_MAP, view);
+   compositorSetVisible(LAYER_MAP, true);
+   compositorPlace(LAYER_TRACK, view);
+   compositorSetVisible(LAYER_TRACK, trackLength() >= 2 && (tileEngineActive() || mapProjectionValid(&mapProj)));
+ 
+   int x = view->width / 2;
+   int y = view->height / 2;
+   bool marker = tileEngineActive() ? markerMotion.valid : imageMarkerPosition(&x, &y);
+   if (marker) {
+     layerMarker = markerBounds(x, y);
+     compositorPlace(LAYER_MARKER, &layerMarker);
+   }
+   compositorSetVisible(LAYER_MARKER, marker);
+ 
+   GdkRectangle hud = {view->x, view->y, PERF_HUD_WIDTH, PERF_HUD_HEIGHT};
+   compositorPlace(LAYER_HUD, &hud);
+   compositorSetVisible(LAYER_HUD, perfHudVisible());
+ }
+ 
+ /**
+  * @brief Renders the map, track, marker and HUD for one frame.
+  *
+  * Shared by the draw handler and headless runs, so both measure the same work.
+  * Only layers damaged since the last frame are repainted; the rest are blended
+  * from their cached surfaces.
+  *
+  * @param cr Cairo context in map widget coordinates, clipped to what needs painting
+  * @param view Visible part of the map widget; the tile view is always at 0, 0
+  */
+ static void renderMap(cairo_t *cr, const GdkRectangle *view) {
+   int64_t drawStart = perfNowUs();
+   if (!tileEngineActive()) mapCacheCheck();
+   placeLayers(view);
+   compositorPaint(cr);
+   perfNoteDraw(perfNowUs() - drawStart, clipArea(cr));
+ }
+ 
+ /**
+  * @brief Draws background map image and overlays a GPS marker based on position.
+  *
+  * The map, breadcrumb track, marker and performance HUD are separate cached
+  * layers (see compositor.h), each repainted only where it was damaged: the map
+  * when it is (re)decoded, a tile arrives or the zoom changes, the track when a
+  * fix extends it, the HUD once per refresh. Scrolling keeps the pixels still
+  * in view. The draw handler itself mostly just blends the layers inside the
+  * clip, so a marker move costs two small boxes. The map surface is decoded on
+  * the worker pool, with a flat placeholder until it is ready, and drawn at
+  * mapZoom from the nearest pyramid level; with a tile source open only the
+  * tiles under the viewport are drawn. Draw time and painted area are recorded
+  * in the perf counters.
+  *
+  * Called automatically by GTK when drawing area needs repainting.
+  */
+ gboolean draw_map_and_marker(GtkWidget *widget, cairo_t *cr, gpointer data) {
+   GdkRectangle view = visibleMapArea();
+   renderMap(cr, &view);
+   return FALSE;
+ }
+ 
+ /**
+  * @brief Draws the speedometer, centred in its widget.
+  *
+  * The dial comes from a cache; only the needle and digits are stroked, and
+  * usually only their boxes are in the clip.
+  */
+ gboolean draw_speed_gauge(GtkWidget *widget, cairo_t *cr, gpointer data) {
+   int width = gtk_widget_get_allocated_width(widget);
+   int height = gtk_widget_get_allocated_height(widget);
+   int size = MIN(width, height);
+   speedGaugePaint(&gauge, cr, (width - size) / 2, (height - size) / 2, size);
    return FALSE;
  }
  
+ /**
+  * @brief Queues the gauge's needle box at a speed for redrawing.
+  */
+ static void damageNeedle(double mph) {
+   GdkRectangle rect;
+   speedGaugeNeedleBounds(&gauge, mph, &rect);
+   gtk_widget_queue_draw_area(guiWindow.speedGauge, rect.x, rect.y, rect.width, rect.height);
+ }
+ 
+ /**
+  * @brief Frame clock callback: sweeps the needle towards the current speed.
+  */
+ static gboolean onGaugeTick(GtkWidget *widget, GdkFrameClock *frameClock, gpointer data) {
+   double before = gauge.shownMph;
+   bool moving = speedGaugeStep(&gauge, gdk_frame_clock_get_frame_time(frameClock));
+   damageNeedle(before);
+   damageNeedle(gauge.shownMph);
+   if (moving) return G_SOURCE_CONTINUE;
+   gaugeTickId = 0;
+   return G_SOURCE_REMOVE;
+ }
+ 
+ /**
+  * @brief Shows a new speed: the digits at once, the needle eased on the frame clock.
+  */
+ static void pushSpeed() {
+   if (!dashboardTakeDirty(&dashboard, DASHBOARD_SPEED)) return;
+   offscreenDirty = true;
+   bool moving = speedGaugeSet(&gauge, dashboard.fields[DASHBOARD_SPEED].value, g_get_monotonic_time());
+   if (!guiWindow.speedGauge) return;
+   if (gauge.size == 0) {
+     gtk_widget_queue_draw(guiWindow.speedGauge);
+   } else {
+     GdkRectangle rect;
+     speedGaugeDigitsBounds(&gauge, &rect);
+     gtk_widget_queue_draw_area(guiWindow.speedGauge, rect.x, rect.y, rect.width, rect.height);
+   }
+   if (moving && gaugeTickId == 0) {
+     gaugeTickId = gtk_widget_add_tick_callback(guiWindow.speedGauge, onGaugeTick, NULL, NULL);
+   }
+ }
+ 
  /**
   * @brief Builds and initializes the GUI layout and widgets.
   *
   * Includes map display, time/speed indicators, air status lights,
-  * timezone dropdown, and signal hookups.
+  * timezone and update rate dropdowns, and signal hookups.
   */
  void initGUI() {
    guiWindow.window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -230,15 +939,29 @@
    gtk_container_add(GTK_CONTAINER(guiWindow.window), hbox);
  
    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-   guiWindow.speedLabel = gtk_label_new("Speed: ");
+   guiWindow.speedGauge = gtk_drawing_area_new();
+   gtk_widget_set_size_request(guiWindow.speedGauge, SPEED_GAUGE_SIZE, SPEED_GAUGE_SIZE);
+   g_signal_connect(G_OBJECT(guiWindow.speedGauge), "draw", G_CALLBACK(draw_speed_gauge), NULL);
    guiWindow.timeZoneDropdown = gtk_combo_box_text_new();
+   guiWindow.rateDropdown = gtk_combo_box_text_new();
    guiWindow.mapArea = gtk_drawing_area_new();
-   gtk_widget_set_size_request(guiWindow.mapArea, 2053, 1368);
+   // Tiles are drawn for whatever viewport the scrolled window gives the map
+   if (!tileEngineActive()) applyMapSize();
    g_signal_connect(G_OBJECT(guiWindow.mapArea), "draw", G_CALLBACK(draw_map_and_marker), NULL);
  
+   // Ctrl+scroll and pinch zoom; event coordinates are in map widget space
+   gtk_widget_add_events(guiWindow.mapArea, GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK | GDK_TOUCH_MASK);
+   g_signal_connect(G_OBJECT(guiWindow.mapArea), "scroll-event", G_CALLBACK(on_map_scroll), NULL);
+   g_signal_connect(G_OBJECT(guiWindow.mapArea), "size-allocate", G_CALLBACK(on_map_size_allocate), NULL);
+   zoomGesture = gtk_gesture_zoom_new(guiWindow.mapArea);
+   gtk_event_controller_set_propagation_phase(GTK_EVENT_CONTROLLER(zoomGesture), GTK_PHASE_BUBBLE);
+   g_signal_connect(zoomGesture, "begin", G_CALLBACK(on_zoom_gesture_begin), NULL);
+   g_signal_connect(zoomGesture, "scale-changed", G_CALLBACK(on_zoom_gesture_scale_changed), NULL);
+ 
    GtkWidget *scroll = gtk_scrolled_window_new(NULL, NULL);
    guiWindow.scrollWindow = scroll;
    gtk_widget_set_size_request(scroll, 300, 300);
+   if (tileEngineActive()) gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scroll), GTK_POLICY_NEVER, GTK_POLICY_NEVER);
    gtk_container_add(GTK_CONTAINER(scroll), guiWindow.mapArea);
    gtk_box_pack_start(GTK_BOX(vbox), scroll, TRUE, TRUE, 0);
  
@@ -251,27 +974,28 @@
      gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(guiWindow.timeZoneDropdown), zones[i]);
    }
  
-   GtkCssProvider *provider = gtk_css_provider_new();
-   gtk_css_provider_load_from_data(provider, "label { font-family: Sans; font-size: 14pt; font-weight: bold; }", -1, NULL);
-   GtkStyleContext *context = gtk_widget_get_style_context(guiWindow.speedLabel);
-   gtk_style_context_add_provider(context, GTK_STYLE_PROVIDER(provider), GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-   g_object_unref(provider);
+   const char *rates[] = {"1 Hz", "2 Hz", "5 Hz"};
+   for (int i = 0; i < 3; i++) {
+     gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(guiWindow.rateDropdown), rates[i]);
+   }
+   gtk_combo_box_set_active(GTK_COMBO_BOX(guiWindow.rateDropdown), 0);
  
    gtk_box_pack_start(GTK_BOX(vbox), guiWindow.timeZoneDropdown, TRUE, TRUE, 0);
-   gtk_box_pack_start(GTK_BOX(vbox), guiWindow.speedLabel, TRUE, TRUE, 0);
+   gtk_box_pack_start(GTK_BOX(vbox), guiWindow.rateDropdown, TRUE, TRUE, 0);
+   gtk_box_pack_start(GTK_BOX(vbox), guiWindow.speedGauge, TRUE, TRUE, 0);
    gtk_box_pack_start(GTK_BOX(hbox), vbox, TRUE, TRUE, 0);
  
    GtkWidget *rightVBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
    guiWindow.timeLabel = gtk_label_new("00:00:00");
+   guiWindow.healthLabel = gtk_label_new(NULL);
+   updateGPSHealth(GINT_TO_POINTER(gpsGetHealth()));
    guiWindow.primaryAirLabel = gtk_label_new("Primary Air");
    guiWindow.secondaryAirLabel = gtk_label_new("Secondary Air");
    guiWindow.leftLabel = gtk_label_new("OIL PLACEHOLDER");
    guiWindow.closeButton = gtk_button_new_with_label("CLOSE");
  
-   GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file_at_scale("red_circle.png", 50, 50, TRUE, NULL);
-   guiWindow.primaryAirCircle = gtk_image_new_from_pixbuf(pixbuf);
-   guiWindow.secondaryAirCircle = gtk_image_new_from_pixbuf(pixbuf);
-   g_object_unref(pixbuf);
+   guiWindow.primaryAirCircle = gtk_image_new_from_pixbuf(iconAtlasPixbuf(ICON_LIGHT_RED));
+   guiWindow.secondaryAirCircle = gtk_image_new_from_pixbuf(iconAtlasPixbuf(ICON_LIGHT_RED));
  
    gtk_widget_set_events(guiWindow.primaryAirCircle, GDK_BUTTON_PRESS_MASK);
    gtk_widget_set_events(guiWindow.secondaryAirCircle, GDK_BUTTON_PRESS_MASK);
@@ -279,6 +1003,7 @@
    g_signal_connect(guiWindow.secondaryAirCircle, "button-press-event", G_CALLBACK(on_circle_clicked), NULL);
  
    gtk_box_pack_start(GTK_BOX(rightVBox), guiWindow.timeLabel, FALSE, FALSE, 0);
+   gtk_box_pack_start(GTK_BOX(rightVBox), guiWindow.healthLabel, FALSE, FALSE, 0);
    gtk_box_pack_start(GTK_BOX(rightVBox), guiWindow.primaryAirLabel, FALSE, FALSE, 0);
    gtk_box_pack_start(GTK_BOX(rightVBox), guiWindow.primaryAirCircle, FALSE, FALSE, 0);
    gtk_box_pack_start(GTK_BOX(rightVBox), guiWindow.secondaryAirLabel, FALSE, FALSE, 0);
@@ -290,8 +1015,14 @@
    gtk_widget_show_all(guiWindow.window);
  
    g_signal_connect(G_OBJECT(guiWindow.timeZoneDropdown), "changed", G_CALLBACK(on_time_zone_changed), NULL);
+   g_signal_connect(G_OBJECT(guiWindow.rateDropdown), "changed", G_CALLBACK(on_rate_changed), NULL);
    g_signal_connect(guiWindow.window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
    g_signal_connect(guiWindow.closeButton, "clicked", G_CALLBACK(on_close_button_clicked), NULL);
+   g_signal_connect(guiWindow.window, "key-press-event", G_CALLBACK(on_key_press), NULL);
+   GtkScrolledWindow *scrolled = GTK_SCROLLED_WINDOW(guiWindow.scrollWindow);
+   g_signal_connect(gtk_scrolled_window_get_hadjustment(scrolled), "value-changed", G_CALLBACK(on_map_scrolled), NULL);
+   g_signal_connect(gtk_scrolled_window_get_vadjustment(scrolled), "value-changed", G_CALLBACK(on_map_scrolled), NULL);
+   if (perfHudVisible()) setHudVisible(true);
  }
  
  /**
@@ -305,72 +1036,290 @@
    guiBackBuffer = guiBufferStruct->bBuffer;
    guiRunning = guiBufferStruct->isRunning;
    gtk_init(NULL, NULL);
+   iconAtlasLoad();
+   initLayers();
+   // Until the first fix picks one, the first map in the catalogue is shown
+   if (!tileEngineActive() && mapCatalogCount() > 0) showMap(mapCatalogEntryAt(0));
    initGUI();
+   if (tileEngineActive()) tileEngineSetReadyFunc(onMapReady, NULL);
    gtk_main();
+   if (hudTimerId != 0) g_source_remove(hudTimerId);
+   hudTimerId = 0;
+   g_clear_object(&zoomGesture);
+   compositorShutdown();
+   speedGaugeFree(&gauge);
+   mapCacheShutdown();
+   trackShutdown();
+   iconAtlasFree();
    return NULL;
  }
  
  /**
-  * @brief Updates GUI labels and map based on current GPS data.
-  *
-  * Accesses front or back buffer based on double-buffering strategy.
+  * @brief State of a run without GTK: headless into an image surface, or to the framebuffer.
   */
- gboolean updateGPSLabels(gpointer data) {
-   gboolean useFirstBuffer = GPOINTER_TO_INT(data);
-   pthread_mutex_lock(&guiBufferStruct->bufferLock);
-   navpvt = (navpvt_data *)(useFirstBuffer ? guiFrontBuffer->payload : guiBackBuffer->payload);
-   pthread_mutex_unlock(&guiBufferStruct->bufferLock);
+ typedef struct offscreenRun {
+   GMainLoop *loop;
+   bool framebuffer;          // draw the dashboard too and show frames on the framebuffer
+   cairo_surface_t *surface;  // headless target
+   int width;
+   int height;
+   int64_t waitUntilUs;       // give up waiting for the map decode at this time
+   int64_t startUs;           // first counted frame, 0 while still waiting
+   int64_t durationUs;        // 0 runs until stopped
+   int64_t hudRefreshUs;
+   GdkRectangle view;         // view of the last frame drawn
+   unsigned long frames;
+ } offscreenRun;
  
-   int rawSpeed = navpvt->gSpeed;
-   float speed_mph = (float)rawSpeed / 447.0;
-   int groundSpeed_mph = (int)(speed_mph + 0.5);
-   if (groundSpeed_mph < 3) groundSpeed_mph = 0;
+ /**
+  * @brief Viewport of an offscreen frame: follows the marker on the image map
+  *        with the same eased, dead-zoned camera as the scrolled window.
+  */
+ static GdkRectangle offscreenView(int width, int height, int64_t nowUs) {
+   GdkRectangle view = {0, 0, width, height};
+   int x, y;
+   if (tileEngineActive() || !imageMarkerPosition(&x, &y)) return view;
+   int mapWidth, mapHeight;
+   mapPixelSize(&mapWidth, &mapHeight);
+   cameraFollow(&camera, x, y, width, height, mapWidth, mapHeight, nowUs);
+   cameraStep(&camera, nowUs);
+   view.x = (int)round(camera.x);
+   view.y = (int)round(camera.y);
+   return view;
+ }
+ 
+ /**
+  * @brief Draws the dashboard column (time, GPS health, speedometer, air pressure)
+  *        for displays without GTK widgets.
+  */
+ static void renderDashboard(cairo_t *cr, int x, int width, int height) {
+   cairo_save(cr);
+   cairo_rectangle(cr, x, 0, width, height);
+   cairo_clip(cr);
+   cairo_set_source_rgb(cr, 0.12, 0.12, 0.12);
+   cairo_paint(cr);
+ 
+   // Matches the 14pt bold Sans of the GTK labels
+   cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+   cairo_set_font_size(cr, 18);
+   cairo_set_source_rgb(cr, 1, 1, 1);
+   const dashboardField *time = &dashboard.fields[DASHBOARD_TIME];
+   cairo_move_to(cr, x + 12, 30);
+   cairo_show_text(cr, time->valid ? time->text : "00:00:00");
+ 
+   gpsHealth state = gpsGetHealth();
+   if (state == GPS_HEALTH_OK) cairo_set_source_rgb(cr, 0.2, 0.8, 0.2);
+   else if (state == GPS_HEALTH_LOST || state == GPS_HEALTH_RECONFIGURING) cairo_set_source_rgb(cr, 0.9, 0.2, 0.2);
+   else cairo_set_source_rgb(cr, 1.0, 0.65, 0.0);
+   char health[64];
+   snprintf(health, sizeof(health), "GPS %s", gpsHealthName(state));
+   cairo_move_to(cr, x + 12, 60);
+   cairo_show_text(cr, health);
+ 
+   speedGaugePaint(&gauge, cr, x + (width - SPEED_GAUGE_SIZE) / 2, 75, SPEED_GAUGE_SIZE);
+ 
+   cairo_set_source_rgb(cr, 1, 1, 1);
+   cairo_move_to(cr, x + 12, 265);
+   cairo_show_text(cr, "Primary Air");
+   iconAtlasPaint(cr, isPrimaryPressureOK ? ICON_LIGHT_GREEN : ICON_LIGHT_RED, x + 12, 275);
+   cairo_set_source_rgb(cr, 1, 1, 1);
+   cairo_move_to(cr, x + 12, 355);
+   cairo_show_text(cr, "Secondary Air");
+   iconAtlasPaint(cr, isSecondaryPressureOK ? ICON_LIGHT_GREEN : ICON_LIGHT_RED, x + 12, 365);
+   cairo_restore(cr);
+ }
  
-   if (GTK_IS_LABEL(guiWindow.timeLabel)) {
-     char timeStr[100];
-     int adjustedHour = (navpvt->hour + utcOffset) % 24;
-     if (adjustedHour < 0) adjustedHour += 24;
-     sprintf(timeStr, "%02d:%02d:%02d", adjustedHour, navpvt->min, navpvt->sec);
-     gtk_label_set_text(GTK_LABEL(guiWindow.timeLabel), timeStr);
+ /**
+  * @brief Renders one offscreen frame.
+  *
+  * Headless runs render every frame so the figures are comparable; the
+  * framebuffer is only redrawn when something on it changed.
+  */
+ static gboolean onOffscreenFrame(gpointer data) {
+   offscreenRun *run = (offscreenRun *)data;
+   int64_t now = g_get_monotonic_time();
+   if (run->startUs == 0) {
+     // Headless frames of the grey placeholder would flatter the figures
+     if (!run->framebuffer && !tileEngineActive() && mapCacheLevels() == 0 && now < run->waitUntilUs) {
+       return G_SOURCE_CONTINUE;
+     }
+     run->startUs = now;
+     if (!run->framebuffer) perfStatsStart("headless");
    }
  
-   if (GTK_IS_LABEL(guiWindow.latitudeLabel)) {
-     char latStr[100];
-     sprintf(latStr, "LAT: %d", navpvt->lat);
-     gtk_label_set_text(GTK_LABEL(guiWindow.latitudeLabel), latStr);
+   if (markerMotion.valid) {
+     shownFix = deadReckonPosition(&markerMotion, now);
+     queueMarkerDamage();
+   }
+   if (run->framebuffer && gauge.moving) {
+     speedGaugeStep(&gauge, now);
+     offscreenDirty = true;
    }
+   if (perfHudVisible() && now >= run->hudRefreshUs) {
+     perfHudRefresh();
+     compositorDamage(LAYER_HUD, NULL);
+     run->hudRefreshUs = now + PERF_HUD_REFRESH_MS * 1000;
+     offscreenDirty = true;
+   }
+ 
+   int mapWidth = run->framebuffer ? run->width - FB_PANEL_WIDTH : run->width;
+   GdkRectangle view = offscreenView(mapWidth, run->height, now);
+   if (!gdk_rectangle_equal(&view, &run->view)) offscreenDirty = true;
  
-   if (GTK_IS_LABEL(guiWindow.longitudeLabel)) {
-     char lonStr[100];
-     sprintf(lonStr, "LON: %d", navpvt->lon);
-     gtk_label_set_text(GTK_LABEL(guiWindow.longitudeLabel), lonStr);
+   if (!run->framebuffer || offscreenDirty) {
+     offscreenDirty = false;
+     run->view = view;
+     cairo_t *cr = cairo_create(run->framebuffer ? fbBackSurface() : run->surface);
+     cairo_save(cr);
+     cairo_rectangle(cr, 0, 0, mapWidth, run->height);
+     cairo_clip(cr);
+     cairo_translate(cr, -view.x, -view.y);
+     renderMap(cr, &view);
+     cairo_restore(cr);
+     if (run->framebuffer) renderDashboard(cr, mapWidth, FB_PANEL_WIDTH, run->height);
+     cairo_destroy(cr);
+     if (run->framebuffer) fbPresent();
+     run->frames++;
    }
  
-   if (GTK_IS_LABEL(guiWindow.speedLabel)) {
-     char speedStr[100];
-     sprintf(speedStr, "Speed: %d", groundSpeed_mph);
-     gtk_label_set_text(GTK_LABEL(guiWindow.speedLabel), speedStr);
+   bool expired = run->durationUs > 0 && now - run->startUs >= run->durationUs;
+   if (!expired && atomic_load(guiRunning)) return G_SOURCE_CONTINUE;
+   g_main_loop_quit(run->loop);
+   return G_SOURCE_REMOVE;
+ }
+ 
+ /**
+  * @brief Stops an offscreen run on SIGINT/SIGTERM, so the framebuffer mode is restored.
+  */
+ static gboolean onOffscreenSignal(gpointer data) {
+   atomic_store(guiRunning, false);
+   return G_SOURCE_CONTINUE;
+ }
+ 
+ /**
+  * @brief Loads the map and runs offscreen frames until the run ends.
+  */
+ static void runOffscreen(void *arg, offscreenRun *run) {
+   guiBufferStruct = (bufferStruct *)arg;
+   guiFrontBuffer = guiBufferStruct->fBuffer;
+   guiBackBuffer = guiBufferStruct->bBuffer;
+   guiRunning = guiBufferStruct->isRunning;
+   run->waitUntilUs = g_get_monotonic_time() + HEADLESS_MAP_WAIT_MS * 1000;
+ 
+   iconAtlasLoad();
+   initLayers();
+   if (tileEngineActive()) {
+     tileEngineSetReadyFunc(onMapReady, NULL);
+   } else if (mapCatalogCount() > 0) {
+     showMap(mapCatalogEntryAt(0));
    }
  
-   gtk_widget_queue_draw(guiWindow.mapArea);
+   // Fixes, worker completions and frames all run on the default main context
+   run->loop = g_main_loop_new(NULL, FALSE);
+   guint sigint = g_unix_signal_add(SIGINT, onOffscreenSignal, NULL);
+   guint sigterm = g_unix_signal_add(SIGTERM, onOffscreenSignal, NULL);
+   g_timeout_add(1000 / OFFSCREEN_FPS, onOffscreenFrame, run);
+   g_main_loop_run(run->loop);
+   g_source_remove(sigint);
+   g_source_remove(sigterm);
+   g_main_loop_unref(run->loop);
+   atomic_store(guiRunning, false);
  
-   double lat = navpvt->lat / 1e7;
-   double lon = navpvt->lon / 1e7;
-   double x = (lon - MAP_LON_LEFT) / (MAP_LON_RIGHT - MAP_LON_LEFT) * gtk_widget_get_allocated_width(guiWindow.mapArea);
-   double y = (MAP_LAT_TOP - lat) / (MAP_LAT_TOP - MAP_LAT_BOTTOM) * gtk_widget_get_allocated_height(guiWindow.mapArea);
+   compositorShutdown();
+   speedGaugeFree(&gauge);
+   mapCacheShutdown();
+   trackShutdown();
+   iconAtlasFree();
+ }
  
-   GtkAdjustment *h_adj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
-   GtkAdjustment *v_adj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(guiWindow.scrollWindow));
+ int startHeadless(void *arg, int width, int height, unsigned int seconds) {
+   offscreenRun run = {0};
+   run.surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+   if (cairo_surface_status(run.surface) != CAIRO_STATUS_SUCCESS) {
+     printf("Error: cannot create a %dx%d offscreen surface\n", width, height);
+     cairo_surface_destroy(run.surface);
+     atomic_store(((bufferStruct *)arg)->isRunning, false);
+     return -1;
+   }
+   run.width = width;
+   run.height = height;
+   run.durationUs = (int64_t)seconds * 1000000;
+   runOffscreen(arg, &run);
+   printf("Headless: %lu frames of %dx%d rendered\n", run.frames, width, height);
+   cairo_surface_destroy(run.surface);
+   return 0;
+ }
  
-   double center_x = x - gtk_adjustment_get_page_size(h_adj) / 2;
-   double center_y = y - gtk_adjustment_get_page_size(v_adj) / 2;
+ int startFramebuffer(void *arg, const char *path, int fileWidth, int fileHeight, unsigned int seconds) {
+   if (fbOpen(path, fileWidth, fileHeight) != 0) {
+     atomic_store(((bufferStruct *)arg)->isRunning, false);
+     return -1;
+   }
+   offscreenRun run = {0};
+   run.framebuffer = true;
+   run.width = fbWidth();
+   run.height = fbHeight();
+   run.durationUs = (int64_t)seconds * 1000000;
+   offscreenDirty = true;
+   runOffscreen(arg, &run);
+   printf("Framebuffer: %lu frames shown\n", run.frames);
+   fbClose();
+   return 0;
+ }
  
-   center_x = CLAMP(center_x, gtk_adjustment_get_lower(h_adj), gtk_adjustment_get_upper(h_adj) - gtk_adjustment_get_page_size(h_adj));
-   center_y = CLAMP(center_y, gtk_adjustment_get_lower(v_adj), gtk_adjustment_get_upper(v_adj) - gtk_adjustment_get_page_size(v_adj));
+ /**
+  * @brief Sets a label to its dashboard field's text, if the text changed.
+  */
+ static void pushDashboardField(GtkWidget *label, dashboardFieldId id) {
+   const char *text = dashboardTakeDirty(&dashboard, id);
+   if (!text) return;
+   offscreenDirty = true;
+   if (!GTK_IS_LABEL(label)) return;
+   gtk_label_set_text(GTK_LABEL(label), text);
+   perfNoteLabelUpdate();
+ }
+ 
+ /**
+  * @brief Updates GUI labels and map based on current GPS data.
+  *
+  * Accesses front or back buffer based on double-buffering strategy. Labels
+  * are only touched when the text they show changes.
+  */
+ gboolean updateGPSLabels(gpointer data) {
+   gboolean useFirstBuffer = GPOINTER_TO_INT(data);
+   pthread_mutex_lock(&guiBufferStruct->bufferLock);
+   navpvt = (navpvt_data *)(useFirstBuffer ? guiFrontBuffer->payload : guiBackBuffer->payload);
+   pthread_mutex_unlock(&guiBufferStruct->bufferLock);
+   perfNotePublished();
  
-   gtk_adjustment_set_value(h_adj, center_x);
-   gtk_adjustment_set_value(v_adj, center_y);
+   dashboardUpdate(&dashboard, navpvt, utcOffset);
+   pushDashboardField(guiWindow.timeLabel, DASHBOARD_TIME);
+   pushSpeed();
  
+   queueMapDamage();
+   selectMap();
+   followMarker(g_get_monotonic_time());
    return G_SOURCE_REMOVE;
  }
  
+ /**
+  * @brief Shows the receiver health reported by the GPS watchdog.
+  *
+  * Invoked on the GTK thread, directly in loop mode or via g_idle_add.
+  */
+ gboolean updateGPSHealth(gpointer data) {
+   gpsHealth state = (gpsHealth)GPOINTER_TO_INT(data);
+   if (!GTK_IS_LABEL(guiWindow.healthLabel)) {
+     offscreenDirty = true;
+     return G_SOURCE_REMOVE;
+   }
+ 
+   const char *color = "orange";
+   if (state == GPS_HEALTH_OK) color = "green";
+   else if (state == GPS_HEALTH_LOST || state == GPS_HEALTH_RECONFIGURING) color = "red";
+ 
+   char markup[100];
+   snprintf(markup, sizeof(markup), "<span foreground=\"%s\">GPS %s</span>", color, gpsHealthName(state));
+   gtk_label_set_markup(GTK_LABEL(guiWindow.healthLabel), markup);
+   return G_SOURCE_REMOVE;
+ }
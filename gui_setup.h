@@ -56,6 +56,9 @@
 #include <glib.h>
 #include <gtk/gtk.h>
 
+// Seconds between simulated pressure changes
+#define PRESSURE_PERIOD_S 3
+
 /**
  * @brief Starts the GUI in a separate thread.
  *
@@ -66,6 +69,40 @@
  */
 void *startGUI(void * arg);
 
+/**
+ * @brief Runs without a display, rendering the map into an offscreen surface.
+ *
+ * Fixes from the reader (threaded or loop mode) are taken in exactly as on
+ * screen, and the map, track, marker and HUD are rendered whole at a fixed
+ * frame rate through the same code as the draw handler. Counting starts once
+ * the map has been decoded; draw times land in the perf report's histogram.
+ *
+ * @param arg Pointer to bufferStruct containing GPS data and sync primitives.
+ * @param width Offscreen frame width in pixels
+ * @param height Offscreen frame height in pixels
+ * @param seconds How long to render after the first counted frame
+ * @return int 0 on success, -1 if the offscreen surface could not be created
+ */
+int startHeadless(void *arg, int width, int height, unsigned int seconds);
+
+/**
+ * @brief Runs the map and dashboard on a Linux framebuffer, without X or Wayland.
+ *
+ * Same layers as startHeadless, drawn with cairo into the mapped framebuffer
+ * with a dashboard column (time, speed, GPS health, air pressure) on the right.
+ * A frame is only drawn when something on it changed, and is shown by page
+ * flipping where the driver allows it. SIGINT and SIGTERM end the run and the
+ * display mode is restored.
+ *
+ * @param arg Pointer to bufferStruct containing GPS data and sync primitives.
+ * @param path Framebuffer device, or a plain file standing in for one
+ * @param fileWidth Frame width used when path is a plain file
+ * @param fileHeight Frame height used when path is a plain file
+ * @param seconds Run length, 0 to run until stopped
+ * @return int 0 on success, -1 if the framebuffer could not be opened
+ */
+int startFramebuffer(void *arg, const char *path, int fileWidth, int fileHeight, unsigned int seconds);
+
 /**
  * @brief Updates GPS labels and map display in the GUI.
  *
@@ -77,6 +114,14 @@ void *startGUI(void * arg);
  */
 gboolean updateGPSLabels(gpointer data);
 
+/**
+ * @brief Updates the GPS health indicator.
+ *
+ * @param data gpsHealth value (as gpointer)
+ * @return gboolean Always returns G_SOURCE_REMOVE
+ */
+gboolean updateGPSHealth(gpointer data);
+
 /**
  * @brief Handles the close button click.
  *
@@ -87,6 +132,21 @@ gboolean updateGPSLabels(gpointer data);
  */
 void on_close_button_clicked(GtkWidget *widget, gpointer data);
 
+/**
+ * @brief Refreshes the pressure indicator icons from the current pressure state.
+ *
+ * Must run on the GTK thread; other threads schedule it with g_idle_add.
+ *
+ * @param data Unused
+ * @return gboolean Always returns G_SOURCE_REMOVE
+ */
+gboolean updatePressureDisplay(gpointer data);
+
+/**
+ * @brief Toggles the simulated primary and secondary pressure states.
+ */
+void stepPressureSimulation();
+
 /**
  * @brief Background thread that simulates tank pressure states.
  *
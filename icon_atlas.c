@@ -0,0 +1,88 @@
+/**
+ * @file        icon_atlas.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Icons decoded and scaled once at startup.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "icon_atlas.h"
+#include "map_cache.h"
+#include <stdio.h>
+
+/**
+ * @brief Source file and display size of each icon.
+ */
+typedef struct iconSpec {
+  const char *path;
+  int size;
+} iconSpec;
+
+static const iconSpec iconSpecs[ICON_COUNT] = {
+  [ICON_LIGHT_GREEN] = {"green_circle.png", ICON_LIGHT_SIZE},
+  [ICON_LIGHT_RED]   = {"red_circle.png", ICON_LIGHT_SIZE},
+  [ICON_MARKER]      = {"loc_icon.png", ICON_MARKER_SIZE},
+};
+
+static GdkPixbuf *iconPixbufs[ICON_COUNT];
+static cairo_surface_t *iconSurfaces[ICON_COUNT];
+
+int iconAtlasLoad() {
+  int missing = 0;
+  for (int i = 0; i < ICON_COUNT; i++) {
+    if (iconPixbufs[i]) continue;
+    iconPixbufs[i] = gdk_pixbuf_new_from_file_at_scale(iconSpecs[i].path, iconSpecs[i].size,
+                                                       iconSpecs[i].size, TRUE, NULL);
+    if (!iconPixbufs[i]) {
+      printf("Error: failed to load icon %s\n", iconSpecs[i].path);
+      missing++;
+      continue;
+    }
+    iconSurfaces[i] = mapSurfaceFromPixbuf(iconPixbufs[i]);
+  }
+  return missing;
+}
+
+GdkPixbuf *iconAtlasPixbuf(iconId id) {
+  return iconPixbufs[id];
+}
+
+void iconAtlasPaint(cairo_t *cr, iconId id, double x, double y) {
+  cairo_surface_t *surface = iconSurfaces[id];
+  if (!surface) return;
+  cairo_save(cr);
+  cairo_set_source_surface(cr, surface, x, y);
+  cairo_rectangle(cr, x, y, cairo_image_surface_get_width(surface), cairo_image_surface_get_height(surface));
+  cairo_fill(cr);
+  cairo_restore(cr);
+}
+
+void iconAtlasFree() {
+  for (int i = 0; i < ICON_COUNT; i++) {
+    if (iconSurfaces[i]) cairo_surface_destroy(iconSurfaces[i]);
+    if (iconPixbufs[i]) g_object_unref(iconPixbufs[i]);
+    iconSurfaces[i] = NULL;
+    iconPixbufs[i] = NULL;
+  }
+}
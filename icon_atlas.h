@@ -0,0 +1,81 @@
+/**
+ * @file        icon_atlas.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Icons decoded and scaled once at startup.
+ *
+ * @details     The pressure lights and the location marker used to be read from disk
+ *              and rescaled in every toggle and draw handler. The atlas loads each icon
+ *              once, at the size it is shown at, and keeps it both as a GdkPixbuf (for
+ *              GtkImage widgets) and as a cairo image surface (for drawing). Event handlers
+ *              only swap references.
+ *
+ *              Load and free on the GTK thread; lookups are read-only afterwards.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef ICON_ATLAS_H
+#define ICON_ATLAS_H
+
+#include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+// Edge length of the pressure status lights
+#define ICON_LIGHT_SIZE 50
+// Edge length of the location marker; the tip of the pin is at the bottom centre
+#define ICON_MARKER_SIZE 24
+
+/**
+ * @brief Icons held by the atlas.
+ */
+typedef enum iconId {
+  ICON_LIGHT_GREEN,
+  ICON_LIGHT_RED,
+  ICON_MARKER,
+  ICON_COUNT
+} iconId;
+
+/**
+ * @brief Decodes and scales every icon.
+ *
+ * @return int Number of icons that could not be loaded (they draw as nothing)
+ */
+int iconAtlasLoad();
+
+/**
+ * @brief Returns the icon as a pixbuf owned by the atlas, or NULL if it failed to load.
+ */
+GdkPixbuf *iconAtlasPixbuf(iconId id);
+
+/**
+ * @brief Paints the icon with its top-left corner at (x, y).
+ */
+void iconAtlasPaint(cairo_t *cr, iconId id, double x, double y);
+
+/**
+ * @brief Releases every icon.
+ */
+void iconAtlasFree();
+
+#endif
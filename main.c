@@ -7,13 +7,36 @@
  *
  * @details     This file contains the `main()` function and orchestrates system initialization 
  *              for a GPS monitoring application on a Raspberry Pi. It:
- *              - Initializes the SPI interface and BCM2835 library
+ *              - Opens the receiver transport (SPI via BCM2835, or the simulated receiver)
  *              - Sets up double-buffered memory for UBX GPS data
  *              - Sends configuration messages to the GPS module
  *              - Polls initial GPS settings for verification
- *              - Starts two threads: one for GPS polling and another for simulating pressure data
+ *              - Starts GPS and pressure I/O, either as two worker threads (threaded mode)
+ *                or as GSources on the GTK main context (loop mode)
+ *              - Starts the background worker pool for heavy off-GUI-thread jobs
  *              - Launches the GTK-based GUI in the main thread
  *
+ *              Command line options:
+ *              - `--mode=threaded|loop`   select the I/O integration mode (default threaded)
+ *              - `--transport=spi|sim`    select the receiver link (default spi)
+ *              - `--bench=SECONDS`        exit after SECONDS and print CPU/wakeup/latency figures
+ *              - `--sim-fault=KIND@S[:D]` inject a simulated receiver fault (silent, garbage,
+ *                                         reset) S seconds after start for D seconds;
+ *                                         needs --transport=sim
+ *              - `--maps=DIR`             directory of georeferenced map images to switch
+ *                                         between (default: the working directory)
+ *              - `--tiles=PATH`           draw the map from a z/x/y tile directory or .mbtiles
+ *                                         file instead of the map images
+ *              - `--tile-cache-mb=N`      budget for decoded tiles (default 32 MB)
+ *              - `--tile-format=F`        keep decoded tiles as argb32 (default) or rgb565,
+ *                                         which halves their memory
+ *              - `--hud`                  start with the performance HUD shown (F3 toggles it)
+ *              - `--headless[=WxH]`       render offscreen with no display for --bench seconds
+ *                                         (default 30) and report draw time percentiles
+ *              - `--framebuffer[=DEV]`    draw map and dashboard straight to a framebuffer
+ *                                         (default /dev/fb0), for kiosks without X/Wayland
+ *              - `--fb-size=WxH`          geometry when DEV is a plain file (default 800x480)
+ *
  *              Upon exit, it performs cleanup of threads, SPI state, mutexes, and allocated memory.
  *              The GPS module is configured to communicate using UBX protocol over SPI.
  *
@@ -41,85 +64,229 @@
 
 #include "gps_setup.h"
 #include "gui_setup.h"
+#include "transport.h"
+#include "event_loop.h"
+#include "perf_stats.h"
+#include "worker_pool.h"
+#include "tile_engine.h"
+#include "map_catalog.h"
+#include "perf_hud.h"
+#include "fb_backend.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <unistd.h>
 #include <string.h>
-#include <bcm2835.h>
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 
 #define I2C_ADDRESS 0x42
-#define SPI_BASE_CLOCK_SPEED 500000000
-#define SPI_BAUD_RATE 115200
+
+// Offscreen frame size and run length of --headless unless given
+#define HEADLESS_DEFAULT_WIDTH 800
+#define HEADLESS_DEFAULT_HEIGHT 480
+#define HEADLESS_DEFAULT_SECONDS 30
+// Geometry of --framebuffer when it names a plain file instead of a device
+#define FB_FILE_DEFAULT_WIDTH 800
+#define FB_FILE_DEFAULT_HEIGHT 480
+
+/**
+ * @brief How GPS and sensor I/O is scheduled relative to the GUI.
+ */
+typedef enum runMode {
+  MODE_THREADED,  // dedicated GPS and pressure threads
+  MODE_LOOP       // GSources on the GTK main context, no extra threads
+} runMode;
+
+/**
+ * @brief Options parsed from the command line.
+ */
+typedef struct appOptions {
+  runMode mode;
+  transportType transport;
+  unsigned int benchSeconds;
+  simFault fault;
+  unsigned int faultStartS;
+  unsigned int faultDurationS;
+  const char *mapsDir;
+  const char *tilePath;
+  unsigned int tileCacheMB;
+  tileStorage tileFormat;
+  bool showHud;
+  bool headless;
+  int headlessWidth;
+  int headlessHeight;
+  const char *fbPath;
+  int fbWidth;
+  int fbHeight;
+} appOptions;
+
+/**
+ * @brief Parses a --sim-fault value of the form KIND@START[:DURATION] (seconds).
+ *
+ * @return int 0 on success, -1 if the value is malformed
+ */
+int parseSimFault(const char *value, appOptions *opts) {
+  char kind[16];
+  unsigned int start = 0;
+  unsigned int duration = 5;
+  if (sscanf(value, "%15[a-z]@%u:%u", kind, &start, &duration) < 2) return -1;
+
+  if (strcmp(kind, "silent") == 0) {
+    opts->fault = SIM_FAULT_SILENT;
+  } else if (strcmp(kind, "garbage") == 0) {
+    opts->fault = SIM_FAULT_GARBAGE;
+  } else if (strcmp(kind, "reset") == 0) {
+    opts->fault = SIM_FAULT_RESET;
+  } else {
+    return -1;
+  }
+  opts->faultStartS = start;
+  opts->faultDurationS = duration;
+  return 0;
+}
+
+/**
+ * @brief Parses command line options into opts.
+ *
+ * @return int 0 on success, -1 on an unknown or malformed option, or a
+ *             --sim-fault without --transport=sim
+ */
+int parseOptions(int argc, char *argv[], appOptions *opts) {
+  opts->mode = MODE_THREADED;
+  opts->transport = TRANSPORT_SPI;
+  opts->benchSeconds = 0;
+  opts->fault = SIM_FAULT_NONE;
+  opts->mapsDir = MAP_CATALOG_DEFAULT_DIR;
+  opts->tilePath = NULL;
+  opts->tileCacheMB = TILE_CACHE_DEFAULT_MB;
+  opts->tileFormat = TILE_STORAGE_ARGB32;
+  opts->showHud = false;
+  opts->headless = false;
+  opts->headlessWidth = HEADLESS_DEFAULT_WIDTH;
+  opts->headlessHeight = HEADLESS_DEFAULT_HEIGHT;
+  opts->fbPath = NULL;
+  opts->fbWidth = FB_FILE_DEFAULT_WIDTH;
+  opts->fbHeight = FB_FILE_DEFAULT_HEIGHT;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--mode=threaded") == 0) {
+      opts->mode = MODE_THREADED;
+    } else if (strcmp(argv[i], "--mode=loop") == 0) {
+      opts->mode = MODE_LOOP;
+    } else if (strcmp(argv[i], "--transport=spi") == 0) {
+      opts->transport = TRANSPORT_SPI;
+    } else if (strcmp(argv[i], "--transport=sim") == 0) {
+      opts->transport = TRANSPORT_SIM;
+    } else if (strncmp(argv[i], "--bench=", 8) == 0) {
+      opts->benchSeconds = (unsigned int)strtoul(argv[i] + 8, NULL, 10);
+    } else if (strncmp(argv[i], "--sim-fault=", 12) == 0 && parseSimFault(argv[i] + 12, opts) == 0) {
+      continue;
+    } else if (strncmp(argv[i], "--maps=", 7) == 0 && argv[i][7] != '\0') {
+      opts->mapsDir = argv[i] + 7;
+    } else if (strncmp(argv[i], "--tiles=", 8) == 0) {
+      opts->tilePath = argv[i] + 8;
+    } else if (strncmp(argv[i], "--tile-cache-mb=", 16) == 0) {
+      opts->tileCacheMB = (unsigned int)strtoul(argv[i] + 16, NULL, 10);
+    } else if (strcmp(argv[i], "--tile-format=argb32") == 0) {
+      opts->tileFormat = TILE_STORAGE_ARGB32;
+    } else if (strcmp(argv[i], "--tile-format=rgb565") == 0) {
+      opts->tileFormat = TILE_STORAGE_RGB565;
+    } else if (strcmp(argv[i], "--hud") == 0) {
+      opts->showHud = true;
+    } else if (strcmp(argv[i], "--headless") == 0) {
+      opts->headless = true;
+    } else if (strncmp(argv[i], "--headless=", 11) == 0 &&
+               sscanf(argv[i] + 11, "%dx%d", &opts->headlessWidth, &opts->headlessHeight) == 2 &&
+               opts->headlessWidth > 0 && opts->headlessHeight > 0) {
+      opts->headless = true;
+    } else if (strcmp(argv[i], "--framebuffer") == 0) {
+      opts->fbPath = FB_DEFAULT_DEVICE;
+    } else if (strncmp(argv[i], "--framebuffer=", 14) == 0 && argv[i][14] != '\0') {
+      opts->fbPath = argv[i] + 14;
+    } else if (strncmp(argv[i], "--fb-size=", 10) == 0 &&
+               sscanf(argv[i] + 10, "%dx%d", &opts->fbWidth, &opts->fbHeight) == 2 &&
+               opts->fbWidth > 0 && opts->fbHeight > 0) {
+      continue;
+    } else {
+      printf("Usage: %s [--mode=threaded|loop] [--transport=spi|sim] [--bench=SECONDS]\n"
+             "          [--sim-fault=silent|garbage|reset@START[:DURATION]]\n"
+             "          [--maps=DIR] [--tiles=DIR|FILE.mbtiles] [--tile-cache-mb=N]\n"
+             "          [--tile-format=argb32|rgb565] [--hud]\n"
+             "          [--headless[=WIDTHxHEIGHT]]\n"
+             "          [--framebuffer[=DEVICE]] [--fb-size=WIDTHxHEIGHT]\n", argv[0]);
+      return -1;
+    }
+  }
+  // Only the simulator can inject faults; anything else would measure a recovery that never happened
+  if (opts->fault != SIM_FAULT_NONE && opts->transport != TRANSPORT_SIM) {
+    printf("Error: --sim-fault needs --transport=sim\n");
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Ends a benchmark run by shutting down exactly as the CLOSE button does.
+ */
+gboolean onBenchElapsed(gpointer data) {
+  on_close_button_clicked(NULL, NULL);
+  return G_SOURCE_REMOVE;
+}
 
 /**
  * @brief Polls the GPS module for configuration status.
  *
- * This function sends requests to retrieve:
+ * This function queues requests to retrieve:
  *  - The current message rate configuration
  *  - The current NAV-PVT message status
  *
- * Short delays are added between commands to allow the module to respond.
+ * Responses are printed by the reader as they arrive.
  */
 void pollModule() {
   pollRate();
-  usleep(10000);
-  readPollResponse();
-
   pollNavPVT();
-  usleep(10000);
-  readPollResponse();
 }
 
 
 /**
- * @brief Sends a set of configuration commands to the GPS module.
+ * @brief Queues a set of configuration commands for the GPS module.
  *
  * Configures the module to:
  *  - Use the UBX protocol exclusively over SPI
- *  - Set the message rate to 2 Hz with a solution rate of 4 Hz
+ *  - Set the message rate to 1 Hz with a measurement rate of 2 Hz
  *  - Enable periodic output of NAV-PVT messages
  *
- * Temporary buffers are allocated to capture ACK/NACK responses from the module.
- * These buffers are freed after configuration is complete.
+ * The commands go out as soon as the reader starts, and each ACK/NACK is
+ * matched to its command and printed as it arrives.
  */
 void sendConfig() {
-  incomingUBX *tempBuffer = (incomingUBX *)malloc(sizeof(incomingUBX));
-  navpvt_data *tempPayload = (navpvt_data *)malloc(sizeof(navpvt_data));
-  tempBuffer->payload = (uint8_t*)tempPayload;
-
   setProtocol_UBX();
-  usleep(10000);
-  readACKResponse("setProtocol_UBX");
-  
   setRate_2x1();
-  usleep(10000);
-  readACKResponse("setRate_2x1");
-  
   enable_navPVT();
-  usleep(10000);
-  readACKResponse("enable_navPVT");  
-
-  free(tempBuffer->payload);
-  free(tempBuffer);
 }
 
 
 /**
  * @brief Main application entry point.
  *
- * Initializes SPI and BCM2835 libraries, prepares double buffers for GPS data,
- * and creates worker threads for GPS reading and pressure simulation.
+ * Opens the selected transport, prepares double buffers for GPS data, and either
+ * creates worker threads for GPS reading and pressure simulation or attaches
+ * equivalent GSources to the GTK main loop.
  *
  * The GUI is launched in the main thread and interacts with the shared buffer structure.
- * Proper cleanup of threads, memory, mutexes, and SPI state is performed before exit.
+ * Proper cleanup of threads, memory, mutexes, and SPI state is performed before exit,
+ * also when startup fails part way.
  *
- * @return int Exit status code
+ * @return int 0 on a normal exit, 1 if startup or the headless or framebuffer run failed
  */
-int main(void) {
+int main(int argc, char *argv[]) {
+  appOptions opts;
+  if (parseOptions(argc, argv, &opts) != 0) {
+    return 1;
+  }
+
   const char *xdg_runtime_dir = getenv("XDG_RUNTIME_DIR");
   if (xdg_runtime_dir) {
     printf("XDG_RUNTIME_DIR: %s\n", xdg_runtime_dir);
@@ -144,55 +311,89 @@ int main(void) {
 
   pthread_t gps_thread;
   pthread_t pressure_thread;
+  bool gpsStarted = false;
+  bool pressureStarted = false;
+  int status = 0;
 
-  uint32_t divider = (SPI_BASE_CLOCK_SPEED / SPI_BAUD_RATE);
+  if (transportOpen(opts.transport) != 0) {
+    return 1;
+  }
 
-  if (!bcm2835_init()) {
-    printf("Error: failed to initialize bcm2835\n");
+  if (opts.tilePath && tileEngineOpen(opts.tilePath, (size_t)opts.tileCacheMB << 20, opts.tileFormat) != 0) {
+    transportClose();
     return 1;
   }
-  printf("BCM2835 Initialized\n");
-
-  bcm2835_spi_begin();
-  printf("SPI STARTED\n");
-  bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-  printf("Bit order set...\n");
-  bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-  printf("SPI data mode set\n");
-  bcm2835_spi_setClockDivider(divider);
-  printf("Clock divider set...\n");
-  bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-  printf("Chip Select pin set\n");
-  bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
-  printf("GPIO and SPI Configured\n\n");
+  if (!opts.tilePath) mapCatalogLoad(opts.mapsDir);
 
   sendConfig();
-  usleep(50000);
   pollModule();
   
   pthread_mutex_init(&buffers.bufferLock, NULL);
 
-  if (pthread_create(&gps_thread, NULL, startGPS, (void*)&buffers)) {
-    printf("Error: Failed to create GPS thread\n");
-    return -1;
+  perfStatsStart(opts.mode == MODE_LOOP ? "loop" : "threaded");
+  if (opts.fault != SIM_FAULT_NONE) {
+    transportSimScheduleFault(opts.fault, opts.faultStartS * 1000, opts.faultDurationS * 1000);
   }
-  if (pthread_create(&pressure_thread, NULL, simulatePressure, NULL)) {
-    printf("Error: Failed to create pressure simulation thread\n");
-    return -1;
+
+  if (opts.mode == MODE_LOOP) {
+    if (eventLoopAttach(&buffers) != 0) {
+      printf("Error: Failed to attach event loop sources\n");
+      status = 1;
+      goto cleanup;
+    }
+  } else {
+    if (pthread_create(&gps_thread, NULL, startGPS, (void*)&buffers)) {
+      printf("Error: Failed to create GPS thread\n");
+      status = 1;
+      goto cleanup;
+    }
+    gpsStarted = true;
+    if (pthread_create(&pressure_thread, NULL, simulatePressure, NULL)) {
+      printf("Error: Failed to create pressure simulation thread\n");
+      status = 1;
+      goto cleanup;
+    }
+    pressureStarted = true;
   }
 
-  startGUI((void*)&buffers);
+  workerPoolStart(0);
 
-  pthread_join(gps_thread, NULL);
-  pthread_join(pressure_thread, NULL);
+  perfHudSetVisible(opts.showHud);
+  if (opts.headless) {
+    unsigned int seconds = opts.benchSeconds > 0 ? opts.benchSeconds : HEADLESS_DEFAULT_SECONDS;
+    if (startHeadless((void*)&buffers, opts.headlessWidth, opts.headlessHeight, seconds) != 0) status = 1;
+  } else if (opts.fbPath) {
+    // A kiosk runs until signalled unless benchmarking
+    if (startFramebuffer((void*)&buffers, opts.fbPath, opts.fbWidth, opts.fbHeight, opts.benchSeconds) != 0) status = 1;
+  } else {
+    if (opts.benchSeconds > 0) {
+      g_timeout_add_seconds(opts.benchSeconds, onBenchElapsed, NULL);
+    }
+    startGUI((void*)&buffers);
+  }
+
+cleanup:
+  // Closing the GUI already cleared it; this also stops a GPS thread the GUI never saw
+  atomic_store(&atomic_bool_isRunning, false);
+  if (opts.mode == MODE_LOOP) {
+    eventLoopDetach();
+  } else {
+    if (gpsStarted) pthread_join(gps_thread, NULL);
+    if (pressureStarted) pthread_join(pressure_thread, NULL);
+  }
+  // Closed first, so tile decodes the pool hands back on stopping just free themselves
+  tileEngineClose();
+  workerPoolStop();
+  mapCatalogFree();
+  // A run that never rendered has no figures worth reporting
+  if (status == 0) perfStatsReport(stdout);
   pthread_mutex_destroy(&buffers.bufferLock);
 
   free(frontBuffer->payload);
   free(backBuffer->payload);
   free(frontBuffer);
   free(backBuffer);
-  bcm2835_spi_end();
-  bcm2835_close();
+  transportClose();
 
-  return 0;
+  return status;
 }
@@ -0,0 +1,427 @@
+/**
+ * @file        map_cache.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Decode-once cache of the map image as a cairo image surface.
+ *
+ * @details     Painting a GdkPixbuf through gdk_cairo_set_source_pixbuf converts every pixel
+ *              (RGBA to premultiplied BGRA) on each draw. Doing that conversion once, on a
+ *              worker, and painting only the clip rectangle of the resulting surface keeps
+ *              draw cost proportional to the damaged area instead of the map size.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_cache.h"
+#include "worker_pool.h"
+#include "perf_stats.h"
+#include "map_raw.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+/**
+ * @brief One background decode of the map file.
+ */
+typedef struct mapDecodeJob {
+  char *path;              // own copies, the map may be switched meanwhile
+  char *rawPath;
+  bool useRaw;             // the pre-decoded file was the newer one when queued
+  struct timespec mtime;   // modification time seen when the decode was queued
+  cairo_surface_t *levels[MAP_PYRAMID_MAX_LEVELS];
+  int levelCount;
+} mapDecodeJob;
+
+static const char *mapPath = NULL;
+static char *rawPath = NULL;       // pre-decoded copy of mapPath, used when at least as new
+static cairo_surface_t *mapLevels[MAP_PYRAMID_MAX_LEVELS];
+static int mapLevelCount = 0;
+static struct timespec mapMtime;   // file version last decoded (or that failed to decode)
+static bool decodePending = false;
+static int64_t lastCheckUs = 0;
+static mapCacheReadyFunc readyFunc = NULL;
+static void *readyData = NULL;
+
+// Map decoded ahead of a switch (mapCachePreload)
+static const char *preloadPath = NULL;
+static cairo_surface_t *preloadLevels[MAP_PYRAMID_MAX_LEVELS];
+static int preloadLevelCount = 0;
+static struct timespec preloadMtime;
+static bool preloadPending = false;
+
+GdkPixbuf *mapPixbufLoad(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return NULL;
+
+  GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+  guchar chunk[MAP_DECODE_CHUNK];
+  bool ok = true;
+  size_t n;
+  while (ok && (n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    ok = gdk_pixbuf_loader_write(loader, chunk, n, NULL);
+  }
+  if (ferror(file)) ok = false;
+  fclose(file);
+
+  // The loader must be closed even after a failed write
+  bool closed = gdk_pixbuf_loader_close(loader, NULL);
+  GdkPixbuf *pixbuf = NULL;
+  if (ok && closed) {
+    pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+    if (pixbuf) g_object_ref(pixbuf);
+  }
+  g_object_unref(loader);
+  return pixbuf;
+}
+
+cairo_surface_t *mapSurfaceFromPixbuf(const GdkPixbuf *pixbuf) {
+  int width = gdk_pixbuf_get_width(pixbuf);
+  int height = gdk_pixbuf_get_height(pixbuf);
+  int channels = gdk_pixbuf_get_n_channels(pixbuf);
+  int srcStride = gdk_pixbuf_get_rowstride(pixbuf);
+  const uint8_t *src = gdk_pixbuf_read_pixels(pixbuf);
+  bool alpha = gdk_pixbuf_get_has_alpha(pixbuf);
+
+  cairo_surface_t *surface = cairo_image_surface_create(alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                                        width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+  cairo_surface_flush(surface);
+  uint8_t *dst = cairo_image_surface_get_data(surface);
+  int dstStride = cairo_image_surface_get_stride(surface);
+
+  for (int y = 0; y < height; y++) {
+    const uint8_t *in = src + (size_t)y * srcStride;
+    uint32_t *out = (uint32_t *)(dst + (size_t)y * dstStride);
+    for (int x = 0; x < width; x++, in += channels) {
+      uint32_t a = alpha ? in[3] : 0xFF;
+      uint32_t r = in[0], g = in[1], b = in[2];
+      if (a != 0xFF) {
+        // Premultiply with rounding: (c * a + 127) / 255
+        r = (r * a + 127) / 255;
+        g = (g * a + 127) / 255;
+        b = (b * a + 127) / 255;
+      }
+      out[x] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+  }
+  cairo_surface_mark_dirty(surface);
+  return surface;
+}
+
+cairo_surface_t *mapSurfaceConvert(cairo_surface_t *src, cairo_format_t format, double r, double g, double b) {
+  int width = cairo_image_surface_get_width(src);
+  int height = cairo_image_surface_get_height(src);
+  cairo_surface_t *surface = cairo_image_surface_create(format, width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+  cairo_t *cr = cairo_create(surface);
+  if (cairo_image_surface_get_format(src) == CAIRO_FORMAT_ARGB32) {
+    cairo_set_source_rgb(cr, r, g, b);
+    cairo_paint(cr);
+  }
+  cairo_set_source_surface(cr, src, 0, 0);
+  cairo_paint(cr);
+  cairo_destroy(cr);
+  return surface;
+}
+
+cairo_surface_t *mapSurfaceHalve(cairo_surface_t *src) {
+  int srcWidth = cairo_image_surface_get_width(src);
+  int srcHeight = cairo_image_surface_get_height(src);
+  int srcStride = cairo_image_surface_get_stride(src);
+  int width = (srcWidth + 1) / 2;
+  int height = (srcHeight + 1) / 2;
+
+  cairo_surface_t *surface = cairo_image_surface_create(cairo_image_surface_get_format(src), width, height);
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return NULL;
+  }
+  cairo_surface_flush(src);
+  cairo_surface_flush(surface);
+  const uint8_t *in = cairo_image_surface_get_data(src);
+  uint8_t *dst = cairo_image_surface_get_data(surface);
+  int dstStride = cairo_image_surface_get_stride(surface);
+
+  for (int y = 0; y < height; y++) {
+    const uint32_t *row0 = (const uint32_t *)(in + (size_t)(2 * y) * srcStride);
+    const uint32_t *row1 = (const uint32_t *)(in + (size_t)MIN(2 * y + 1, srcHeight - 1) * srcStride);
+    uint32_t *out = (uint32_t *)(dst + (size_t)y * dstStride);
+    for (int x = 0; x < width; x++) {
+      int x0 = 2 * x;
+      int x1 = MIN(x0 + 1, srcWidth - 1);
+      uint32_t a = row0[x0], b = row0[x1], c = row1[x0], d = row1[x1];
+      // Two 8-bit channels per 16-bit lane: the sum of four fits without carrying over
+      uint32_t rb = (a & 0x00FF00FF) + (b & 0x00FF00FF) + (c & 0x00FF00FF) + (d & 0x00FF00FF) + 0x00020002;
+      uint32_t ag = ((a >> 8) & 0x00FF00FF) + ((b >> 8) & 0x00FF00FF) +
+                    ((c >> 8) & 0x00FF00FF) + ((d >> 8) & 0x00FF00FF) + 0x00020002;
+      out[x] = ((rb >> 2) & 0x00FF00FF) | (((ag >> 2) & 0x00FF00FF) << 8);
+    }
+  }
+  cairo_surface_mark_dirty(surface);
+  return surface;
+}
+
+int mapPyramidBuild(cairo_surface_t **levels) {
+  int count = 1;
+  while (count < MAP_PYRAMID_MAX_LEVELS) {
+    cairo_surface_t *prev = levels[count - 1];
+    if (cairo_image_surface_get_width(prev) / 2 < MAP_PYRAMID_MIN_SIZE ||
+        cairo_image_surface_get_height(prev) / 2 < MAP_PYRAMID_MIN_SIZE) break;
+    cairo_surface_t *next = mapSurfaceHalve(prev);
+    if (!next) break;
+    levels[count++] = next;
+  }
+  return count;
+}
+
+/**
+ * @brief Worker job: maps the pre-decoded file, or decodes the image, converts
+ *        it to a surface and builds its pyramid.
+ */
+static void decodeJob(void *data) {
+  mapDecodeJob *job = (mapDecodeJob *)data;
+  int64_t start = perfNowUs();
+  if (job->useRaw) {
+    job->levelCount = mapRawOpen(job->rawPath, job->levels);
+    if (job->levelCount > 0) {
+      printf("Map %s mapped in %.1f ms (%d levels)\n", job->rawPath, (perfNowUs() - start) / 1000.0, job->levelCount);
+      return;
+    }
+  }
+
+  GdkPixbuf *pixbuf = mapPixbufLoad(job->path);
+  if (!pixbuf) return;
+  job->levels[0] = mapSurfaceFromPixbuf(pixbuf);
+  g_object_unref(pixbuf);
+  if (!job->levels[0]) return;
+  job->levelCount = mapPyramidBuild(job->levels);
+  printf("Map %s decoded in %.1f ms (%d levels)\n", job->path, (perfNowUs() - start) / 1000.0, job->levelCount);
+}
+
+static void freeLevels() {
+  for (int i = 0; i < mapLevelCount; i++) cairo_surface_destroy(mapLevels[i]);
+  mapLevelCount = 0;
+}
+
+static void freePreload() {
+  for (int i = 0; i < preloadLevelCount; i++) cairo_surface_destroy(preloadLevels[i]);
+  preloadLevelCount = 0;
+}
+
+static bool samePath(const char *a, const char *b) {
+  return a && b && strcmp(a, b) == 0;
+}
+
+/**
+ * @brief Completion on the GTK thread: swaps in the new surface, or keeps a
+ *        preloaded one for later.
+ */
+static void decodeDone(void *data) {
+  mapDecodeJob *job = (mapDecodeJob *)data;
+  if (samePath(job->path, mapPath)) {
+    decodePending = false;
+    if (job->levelCount > 0) {
+      freeLevels();
+      for (int i = 0; i < job->levelCount; i++) mapLevels[i] = job->levels[i];
+      mapLevelCount = job->levelCount;
+      if (readyFunc) readyFunc(readyData);
+    } else {
+      printf("Error: failed to decode map %s\n", job->path);
+    }
+    // Remembering failed versions too stops a broken file being decoded in a loop
+    mapMtime = job->mtime;
+  } else if (samePath(job->path, preloadPath)) {
+    preloadPending = false;
+    freePreload();
+    for (int i = 0; i < job->levelCount; i++) preloadLevels[i] = job->levels[i];
+    preloadLevelCount = job->levelCount;
+    preloadMtime = job->mtime;
+  } else {
+    // The map was switched away from while it decoded
+    for (int i = 0; i < job->levelCount; i++) cairo_surface_destroy(job->levels[i]);
+  }
+  g_free(job->path);
+  g_free(job->rawPath);
+  free(job);
+}
+
+static bool newerThan(struct timespec a, struct timespec b) {
+  return a.tv_sec > b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec > b.tv_nsec);
+}
+
+/**
+ * @brief Modification time of the newer of the image and its pre-decoded copy.
+ *
+ * @param useRaw Set if the pre-decoded copy is the one to load
+ */
+static bool readMtime(const char *path, const char *raw, struct timespec *mtime, bool *useRaw) {
+  struct stat st;
+  bool haveImage = stat(path, &st) == 0;
+  if (haveImage) *mtime = st.st_mtim;
+  *useRaw = false;
+  if (raw && stat(raw, &st) == 0 && (!haveImage || !newerThan(*mtime, st.st_mtim))) {
+    *mtime = st.st_mtim;
+    *useRaw = true;
+  }
+  return haveImage || *useRaw;
+}
+
+static void queueDecode(const char *path, const char *raw, struct timespec mtime, bool useRaw) {
+  mapDecodeJob *job = (mapDecodeJob *)calloc(1, sizeof(mapDecodeJob));
+  job->path = g_strdup(path);
+  job->rawPath = g_strdup(raw);
+  job->useRaw = useRaw;
+  job->mtime = mtime;
+  workerPoolSubmit(decodeJob, decodeDone, job);
+}
+
+/**
+ * @brief Queues a re-decode if the file changed, at most once per check interval.
+ */
+static void checkForChange() {
+  if (decodePending || !mapPath) return;
+  int64_t now = perfNowUs();
+  if (lastCheckUs > 0 && now - lastCheckUs < MAP_CACHE_CHECK_INTERVAL_MS * 1000) return;
+  lastCheckUs = now;
+
+  struct timespec mtime;
+  bool useRaw;
+  if (!readMtime(mapPath, rawPath, &mtime, &useRaw)) return;
+  if (mtime.tv_sec == mapMtime.tv_sec && mtime.tv_nsec == mapMtime.tv_nsec) return;
+  queueDecode(mapPath, rawPath, mtime, useRaw);
+  decodePending = true;
+}
+
+void mapCacheInit(const char *path, mapCacheReadyFunc onReady, void *data) {
+  // Another map's surface must not be drawn under this map's projection
+  if (!samePath(path, mapPath)) freeLevels();
+  mapPath = path;
+  free(rawPath);
+  rawPath = mapRawPathFor(path);
+  readyFunc = onReady;
+  readyData = data;
+  mapMtime.tv_sec = -1;
+  mapMtime.tv_nsec = 0;
+  lastCheckUs = 0;
+  decodePending = false;
+
+  if (samePath(path, preloadPath)) {
+    if (preloadLevelCount > 0) {
+      freeLevels();
+      for (int i = 0; i < preloadLevelCount; i++) mapLevels[i] = preloadLevels[i];
+      mapLevelCount = preloadLevelCount;
+      preloadLevelCount = 0;
+      mapMtime = preloadMtime;
+      if (readyFunc) readyFunc(readyData);
+    } else if (preloadPending) {
+      // The preload still decoding is adopted by decodeDone as this map's decode
+      decodePending = true;
+    }
+    preloadPath = NULL;
+    preloadPending = false;
+  }
+  checkForChange();
+}
+
+void mapCachePreload(const char *path) {
+  if (!path || samePath(path, mapPath) || samePath(path, preloadPath)) return;
+  freePreload();
+  preloadPath = path;
+  preloadPending = false;
+
+  char *raw = mapRawPathFor(path);
+  struct timespec mtime;
+  bool useRaw;
+  if (readMtime(path, raw, &mtime, &useRaw)) {
+    queueDecode(path, raw, mtime, useRaw);
+    preloadPending = true;
+    printf("Map %s preloading\n", path);
+  }
+  free(raw);
+}
+
+bool mapCachePaint(cairo_t *cr, double zoom) {
+  checkForChange();
+  if (mapLevelCount == 0) return false;
+
+  // Nearest level at or above the zoom, so cairo minifies by at most 2:1
+  int level = 0;
+  while (level + 1 < mapLevelCount && zoom <= 1.0 / (2 << level)) level++;
+  cairo_surface_t *surface = mapLevels[level];
+  double scale = zoom * (1 << level);
+
+  double x1, y1, x2, y2;
+  cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+  int width = cairo_image_surface_get_width(surface);
+  int height = cairo_image_surface_get_height(surface);
+  x1 /= scale;
+  y1 /= scale;
+  x2 /= scale;
+  y2 /= scale;
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 > width) x2 = width;
+  if (y2 > height) y2 = height;
+  if (x2 <= x1 || y2 <= y1) return true;
+
+  cairo_save(cr);
+  cairo_scale(cr, scale, scale);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface(cr, surface, 0, 0);
+  cairo_pattern_set_filter(cairo_get_source(cr), scale == 1.0 ? CAIRO_FILTER_FAST : CAIRO_FILTER_BILINEAR);
+  cairo_rectangle(cr, x1, y1, x2 - x1, y2 - y1);
+  cairo_fill(cr);
+  cairo_restore(cr);
+  return true;
+}
+
+void mapCacheCheck() {
+  checkForChange();
+}
+
+cairo_surface_t *mapCacheSurface() {
+  return mapLevelCount > 0 ? mapLevels[0] : NULL;
+}
+
+int mapCacheLevels() {
+  return mapLevelCount;
+}
+
+void mapCacheShutdown() {
+  freeLevels();
+  freePreload();
+  preloadPath = NULL;
+  preloadPending = false;
+  mapPath = NULL;
+  free(rawPath);
+  rawPath = NULL;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file        map_cache.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Decode-once cache of the map image as a cairo image surface.
+ *
+ * @details     The map PNG is decoded on the worker pool and converted once into a cairo
+ *              image surface in the native (premultiplied ARGB32 / RGB24) format, so drawing
+ *              it is a plain clipped blit with no per-draw pixel conversion. The file's
+ *              modification time is rechecked at most once per MAP_CACHE_CHECK_INTERVAL_MS
+ *              and a changed file is decoded again in the background while the old surface
+ *              keeps being drawn.
+ *
+ *              Each decode also builds a pyramid of half-size levels, so zoomed-out views
+ *              are drawn from the nearest level at or above the requested scale and cairo
+ *              never has to minify more than 2:1. Draw cost then tracks the clip area, not
+ *              the zoom.
+ *
+ *              If a converted .rawmap (see map_raw.h) is at least as new as the
+ *              image, it is memory-mapped instead, pyramid included, and nothing is decoded.
+ *
+ *              When maps are switched (see map_catalog.h), the next map can be decoded ahead
+ *              of time with mapCachePreload and is then swapped in without a wait.
+ *
+ *              All functions except the decode job itself run on the GTK thread.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include <stdbool.h>
+#include <cairo.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+// Minimum time between checks of the map file's modification time
+#define MAP_CACHE_CHECK_INTERVAL_MS 1000
+// Most pyramid levels kept, level 0 being the full-size map
+#define MAP_PYRAMID_MAX_LEVELS 8
+// Levels stop once either side would drop below this many pixels
+#define MAP_PYRAMID_MIN_SIZE 128
+// Bytes of compressed image fed to the decoder at a time
+#define MAP_DECODE_CHUNK 16384
+
+/**
+ * @brief Called on the GTK thread whenever a new surface has been installed.
+ */
+typedef void (*mapCacheReadyFunc)(void *data);
+
+/**
+ * @brief Starts caching the given map file and queues its first decode.
+ *
+ * Switching to a different file drops the old surface straight away. If the
+ * file was preloaded it is installed at once (onReady is called before this
+ * returns), or as soon as its preload finishes.
+ *
+ * @param path Map image path (kept by reference)
+ * @param onReady Called after each successful (re)decode, may be NULL
+ * @param data Passed to onReady
+ */
+void mapCacheInit(const char *path, mapCacheReadyFunc onReady, void *data);
+
+/**
+ * @brief Decodes another map file in the background, ready for a later mapCacheInit.
+ *
+ * Only one map is held preloaded; preloading another replaces it. Does
+ * nothing for the current or already preloaded file.
+ *
+ * @param path Map image path (kept by reference)
+ */
+void mapCachePreload(const char *path);
+
+/**
+ * @brief Paints the part of the cached map inside the current clip.
+ *
+ * Picks the pyramid level nearest to, and not smaller than, the zoom. Also
+ * schedules a background re-decode if the file changed on disk.
+ *
+ * @param cr Cairo context in widget coordinates (map pixels times zoom)
+ * @param zoom Display scale, 1.0 being the map's native size
+ * @return bool False if no surface is available yet (caller paints a placeholder)
+ */
+bool mapCachePaint(cairo_t *cr, double zoom);
+
+/**
+ * @brief Schedules a background re-decode if the file changed on disk.
+ *
+ * mapCachePaint does this itself; call it on frames that do not repaint the
+ * map, so a changed file is still picked up. Rate-limited and cheap.
+ */
+void mapCacheCheck();
+
+/**
+ * @brief Returns the full-size cached surface without taking a reference, or NULL.
+ */
+cairo_surface_t *mapCacheSurface();
+
+/**
+ * @brief Number of pyramid levels currently cached (0 before the first decode).
+ */
+int mapCacheLevels();
+
+/**
+ * @brief Downsamples an image surface to half size with a 2x2 box filter.
+ *
+ * Odd edges repeat their last row or column. Works on ARGB32 and RGB24,
+ * averaging all four channels at once with packed (SWAR) arithmetic.
+ * Thread-safe.
+ *
+ * @return cairo_surface_t* New surface, or NULL on allocation failure
+ */
+cairo_surface_t *mapSurfaceHalve(cairo_surface_t *src);
+
+/**
+ * @brief Decodes an image file incrementally through a GdkPixbufLoader.
+ *
+ * The file is read and decoded MAP_DECODE_CHUNK bytes at a time, so the
+ * compressed image is never held whole. Thread-safe; meant for workers.
+ *
+ * @return GdkPixbuf* New reference, or NULL if the file is missing or corrupt
+ */
+GdkPixbuf *mapPixbufLoad(const char *path);
+
+/**
+ * @brief Fills in the half-size levels below levels[0].
+ *
+ * Stops at MAP_PYRAMID_MAX_LEVELS or once a side would drop below
+ * MAP_PYRAMID_MIN_SIZE. Thread-safe.
+ *
+ * @param levels levels[0] is the full-size surface; receives the smaller levels
+ * @return int Number of levels, including levels[0]
+ */
+int mapPyramidBuild(cairo_surface_t **levels);
+
+/**
+ * @brief Converts a pixbuf into a new cairo image surface.
+ *
+ * RGB pixbufs become RGB24, RGBA pixbufs premultiplied ARGB32. Thread-safe;
+ * needs no display connection.
+ *
+ * @return cairo_surface_t* New surface, or NULL on allocation failure
+ */
+cairo_surface_t *mapSurfaceFromPixbuf(const GdkPixbuf *pixbuf);
+
+/**
+ * @brief Copies an image surface into another image format.
+ *
+ * The conversion is a single cairo blit, so it runs on pixman's SIMD paths
+ * (NEON on the Pi) where they exist. Transparent parts are flattened onto
+ * the background colour when the target has no alpha. Thread-safe.
+ *
+ * @param src Surface to convert
+ * @param format Target format, e.g. CAIRO_FORMAT_RGB16_565
+ * @param r Background red (0-1)
+ * @param g Background green (0-1)
+ * @param b Background blue (0-1)
+ * @return cairo_surface_t* New surface, or NULL on allocation failure
+ */
+cairo_surface_t *mapSurfaceConvert(cairo_surface_t *src, cairo_format_t format, double r, double g, double b);
+
+/**
+ * @brief Releases the cached surface.
+ */
+void mapCacheShutdown();
+
+#endif
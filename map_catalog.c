@@ -0,0 +1,311 @@
+/**
+ * @file        map_catalog.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Catalogue of georeferenced map images with a spatial index of their extents.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_catalog.h"
+#include "map_cache.h"
+#include "map_raw.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+// Metres per degree of latitude (and of longitude at the equator)
+#define METRES_PER_DEGREE 111320.0
+// Nodes waiting to be visited during a lookup; 8^9 maps would still fit
+#define MAP_CATALOG_STACK_SIZE 64
+
+/**
+ * @brief Bounding box in degrees.
+ */
+typedef struct catalogBox {
+  double west, south, east, north;
+} catalogBox;
+
+/**
+ * @brief R-tree node. Its children are links[first .. first + count).
+ */
+typedef struct catalogNode {
+  catalogBox box;
+  int first;
+  int count;
+  bool leaf;       // children are entry indices rather than node indices
+} catalogNode;
+
+/**
+ * @brief A box being packed into the level above, and the entry or node it stands for.
+ */
+typedef struct packItem {
+  catalogBox box;
+  int index;
+} packItem;
+
+static mapCatalogEntry *entries = NULL;
+static int entryCount = 0;
+static GArray *nodes = NULL;     // catalogNode
+static GArray *links = NULL;     // int
+static int rootNode = -1;
+
+//////////////// LOADING //////////////////
+
+/**
+ * @brief Reads an image's size from its header, or from its pre-decoded copy.
+ */
+static bool imageSize(const char *imagePath, int *width, int *height) {
+  if (gdk_pixbuf_get_file_info(imagePath, width, height)) return true;
+
+  // Only the .rawmap may have been copied to the card
+  char *rawPath = mapRawPathFor(imagePath);
+  cairo_surface_t *levels[MAP_PYRAMID_MAX_LEVELS];
+  int count = mapRawOpen(rawPath, levels);
+  free(rawPath);
+  if (count == 0) return false;
+  *width = cairo_image_surface_get_width(levels[0]);
+  *height = cairo_image_surface_get_height(levels[0]);
+  for (int i = 0; i < count; i++) cairo_surface_destroy(levels[i]);
+  return true;
+}
+
+/**
+ * @brief Fills in one entry from a sidecar and the image next to it.
+ *
+ * @return int 0 on success, -1 if the map is unusable
+ */
+static int loadEntry(mapCatalogEntry *entry, const char *geoPath) {
+  size_t stem = strlen(geoPath) - strlen(".geo");
+  char *imagePath = g_strdup_printf("%.*s.png", (int)stem, geoPath);
+  int width, height;
+  if (!imageSize(imagePath, &width, &height)) {
+    printf("Error: no image for map %s\n", geoPath);
+    g_free(imagePath);
+    return -1;
+  }
+  // The sidecar's own width= and height= still take precedence, as for a single map
+  if (mapProjectionLoad(&entry->proj, geoPath, width, height) != 0) {
+    g_free(imagePath);
+    return -1;
+  }
+  entry->imagePath = imagePath;
+  entry->pixelsPerDegree = entry->proj.width / (entry->proj.east - entry->proj.west);
+  return 0;
+}
+
+static int compareNames(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+//////////////// INDEX //////////////////
+
+static catalogBox unionBox(catalogBox a, catalogBox b) {
+  catalogBox box = {fmin(a.west, b.west), fmin(a.south, b.south), fmax(a.east, b.east), fmax(a.north, b.north)};
+  return box;
+}
+
+static int compareCentreX(const void *a, const void *b) {
+  double x = ((const packItem *)a)->box.west + ((const packItem *)a)->box.east;
+  double y = ((const packItem *)b)->box.west + ((const packItem *)b)->box.east;
+  return (x > y) - (x < y);
+}
+
+static int compareCentreY(const void *a, const void *b) {
+  double x = ((const packItem *)a)->box.south + ((const packItem *)a)->box.north;
+  double y = ((const packItem *)b)->box.south + ((const packItem *)b)->box.north;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Packs one level of the tree (Sort-Tile-Recursive).
+ *
+ * Items are sorted into vertical slices by centre longitude and each slice by
+ * centre latitude, so every run of MAP_CATALOG_NODE_SIZE items is a compact
+ * tile and becomes one node. The nodes replace the items, ready for the next
+ * level up.
+ *
+ * @return int Number of nodes made
+ */
+static int packLevel(packItem *items, int count, bool leaf) {
+  int nodeTotal = (count + MAP_CATALOG_NODE_SIZE - 1) / MAP_CATALOG_NODE_SIZE;
+  int sliceSize = (int)ceil(sqrt((double)nodeTotal)) * MAP_CATALOG_NODE_SIZE;
+  qsort(items, count, sizeof(packItem), compareCentreX);
+  for (int s = 0; s < count; s += sliceSize) {
+    int n = count - s < sliceSize ? count - s : sliceSize;
+    qsort(items + s, n, sizeof(packItem), compareCentreY);
+  }
+
+  int made = 0;
+  for (int i = 0; i < count; i += MAP_CATALOG_NODE_SIZE) {
+    catalogNode node = {items[i].box, (int)links->len, 0, leaf};
+    for (int j = i; j < count && j < i + MAP_CATALOG_NODE_SIZE; j++) {
+      g_array_append_val(links, items[j].index);
+      node.box = unionBox(node.box, items[j].box);
+      node.count++;
+    }
+    g_array_append_val(nodes, node);
+    // Slot made is already consumed, as made <= i / MAP_CATALOG_NODE_SIZE
+    items[made].box = node.box;
+    items[made].index = (int)nodes->len - 1;
+    made++;
+  }
+  return made;
+}
+
+static void buildIndex() {
+  nodes = g_array_new(FALSE, FALSE, sizeof(catalogNode));
+  links = g_array_new(FALSE, FALSE, sizeof(int));
+  rootNode = -1;
+  if (entryCount == 0) return;
+
+  packItem *items = (packItem *)malloc(entryCount * sizeof(packItem));
+  for (int i = 0; i < entryCount; i++) {
+    const mapProjection *p = &entries[i].proj;
+    items[i].box = (catalogBox){p->west, p->south, p->east, p->north};
+    items[i].index = i;
+  }
+  int count = packLevel(items, entryCount, true);
+  while (count > 1) count = packLevel(items, count, false);
+  rootNode = items[0].index;
+  free(items);
+}
+
+/**
+ * @brief True if a position is inside a map, at least margin (a fraction of
+ *        the map's size) from its edges.
+ */
+static bool entryCovers(const mapCatalogEntry *entry, double lat, double lon, double margin) {
+  const mapProjection *p = &entry->proj;
+  double dx = (p->east - p->west) * margin;
+  double dy = (p->north - p->south) * margin;
+  return lon >= p->west + dx && lon <= p->east - dx && lat >= p->south + dy && lat <= p->north - dy;
+}
+
+/**
+ * @brief Walks the tree for the best map covering a position (see mapCatalogFind).
+ */
+static const mapCatalogEntry *findAt(double lat, double lon, const mapCatalogEntry *current) {
+  if (rootNode < 0) return NULL;
+  const mapCatalogEntry *best = NULL;
+  int stack[MAP_CATALOG_STACK_SIZE];
+  int top = 0;
+  stack[top++] = rootNode;
+  while (top > 0) {
+    const catalogNode *node = &g_array_index(nodes, catalogNode, stack[--top]);
+    const catalogBox *box = &node->box;
+    if (lon < box->west || lon > box->east || lat < box->south || lat > box->north) continue;
+
+    for (int i = 0; i < node->count; i++) {
+      int child = g_array_index(links, int, node->first + i);
+      if (!node->leaf) {
+        if (top < MAP_CATALOG_STACK_SIZE) stack[top++] = child;
+        continue;
+      }
+      const mapCatalogEntry *entry = &entries[child];
+      // The current map is kept to its very edge; others must be entered by the margin
+      if (!entryCovers(entry, lat, lon, entry == current ? 0.0 : MAP_CATALOG_EDGE_MARGIN)) continue;
+      if (!best || entry->pixelsPerDegree > best->pixelsPerDegree ||
+          (entry->pixelsPerDegree == best->pixelsPerDegree && entry == current)) {
+        best = entry;
+      }
+    }
+  }
+  return best;
+}
+
+//////////////// API //////////////////
+
+int mapCatalogLoad(const char *dir) {
+  mapCatalogFree();
+  GDir *d = g_dir_open(dir, 0, NULL);
+  if (!d) {
+    printf("Error: cannot open map directory %s\n", dir);
+    buildIndex();
+    return 0;
+  }
+  GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+  const gchar *name;
+  while ((name = g_dir_read_name(d)) != NULL) {
+    if (g_str_has_suffix(name, ".geo")) g_ptr_array_add(names, g_strdup(name));
+  }
+  g_dir_close(d);
+  g_ptr_array_sort(names, compareNames);
+
+  entries = (mapCatalogEntry *)calloc(names->len > 0 ? names->len : 1, sizeof(mapCatalogEntry));
+  for (guint i = 0; i < names->len; i++) {
+    char *geoPath = g_build_filename(dir, (const char *)g_ptr_array_index(names, i), NULL);
+    if (loadEntry(&entries[entryCount], geoPath) == 0) entryCount++;
+    g_free(geoPath);
+  }
+  g_ptr_array_free(names, TRUE);
+
+  buildIndex();
+  printf("Maps: %d in %s (%u index nodes)\n", entryCount, dir, nodes->len);
+  return entryCount;
+}
+
+int mapCatalogCount() {
+  return entryCount;
+}
+
+const mapCatalogEntry *mapCatalogEntryAt(int index) {
+  return index >= 0 && index < entryCount ? &entries[index] : NULL;
+}
+
+const mapCatalogEntry *mapCatalogFind(mapCoord pos, const mapCatalogEntry *current) {
+  return findAt(pos.latE7 / 1e7, pos.lonE7 / 1e7, current);
+}
+
+const mapCatalogEntry *mapCatalogAhead(mapCoord pos, int32_t velN, int32_t velE, const mapCatalogEntry *current) {
+  double speed = hypot(velN, velE);
+  if (rootNode < 0 || speed < MAP_CATALOG_MIN_SPEED_MMS) return NULL;
+
+  double metres = speed / 1000.0 * MAP_CATALOG_LOOKAHEAD_S;
+  if (metres < MAP_CATALOG_LOOKAHEAD_MIN_M) metres = MAP_CATALOG_LOOKAHEAD_MIN_M;
+  double lat = pos.latE7 / 1e7;
+  double lon = pos.lonE7 / 1e7;
+  double stepLat = velN / speed * metres / METRES_PER_DEGREE / MAP_CATALOG_LOOKAHEAD_STEPS;
+  double stepLon = velE / speed * metres / (METRES_PER_DEGREE * cos(lat * M_PI / 180.0)) /
+                   MAP_CATALOG_LOOKAHEAD_STEPS;
+  for (int i = 1; i <= MAP_CATALOG_LOOKAHEAD_STEPS; i++) {
+    const mapCatalogEntry *entry = findAt(lat + stepLat * i, lon + stepLon * i, current);
+    if (entry && entry != current) return entry;
+  }
+  return NULL;
+}
+
+void mapCatalogFree() {
+  for (int i = 0; i < entryCount; i++) g_free(entries[i].imagePath);
+  free(entries);
+  entries = NULL;
+  entryCount = 0;
+  if (nodes) g_array_free(nodes, TRUE);
+  if (links) g_array_free(links, TRUE);
+  nodes = NULL;
+  links = NULL;
+  rootNode = -1;
+}
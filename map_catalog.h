@@ -0,0 +1,128 @@
+/**
+ * @file        map_catalog.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Catalogue of georeferenced map images with a spatial index of their extents.
+ *
+ * @details     Every `<name>.geo` sidecar in the maps directory (see map_projection.h)
+ *              together with its `<name>.png` (or pre-decoded `<name>.rawmap`) is one
+ *              catalogue entry. The entries' bounding boxes are bulk-loaded into a static
+ *              R-tree (Sort-Tile-Recursive packing, MAP_CATALOG_NODE_SIZE children per
+ *              node), so finding the maps under a position visits O(log n) nodes however
+ *              many maps there are.
+ *
+ *              Where maps overlap, the one with the most pixels per degree wins. A map
+ *              other than the current one is only chosen once the position is
+ *              MAP_CATALOG_EDGE_MARGIN inside it, so driving along a shared edge does not
+ *              flip between the two.
+ *
+ *              mapCatalogAhead looks along the current heading for the map that will be
+ *              needed next, so it can be decoded before the vehicle reaches the edge.
+ *
+ *              The catalogue is loaded once at startup and is read-only afterwards.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef MAP_CATALOG_H
+#define MAP_CATALOG_H
+
+#include "map_projection.h"
+#include <stdint.h>
+
+// Directory searched for maps unless --maps names another
+#define MAP_CATALOG_DEFAULT_DIR "."
+// Children per R-tree node
+#define MAP_CATALOG_NODE_SIZE 8
+// How far inside a map (as a fraction of its size) a fix must be before switching to it
+#define MAP_CATALOG_EDGE_MARGIN 0.02
+// Prefetch looks this many seconds of travel ahead...
+#define MAP_CATALOG_LOOKAHEAD_S 60
+// ...but never less than this many metres
+#define MAP_CATALOG_LOOKAHEAD_MIN_M 500
+// Below this ground speed the heading is noise and nothing is prefetched
+#define MAP_CATALOG_MIN_SPEED_MMS 1000
+// Points sampled along the look-ahead path
+#define MAP_CATALOG_LOOKAHEAD_STEPS 4
+
+/**
+ * @brief One georeferenced map.
+ */
+typedef struct mapCatalogEntry {
+  char *imagePath;
+  mapProjection proj;
+  double pixelsPerDegree;   // horizontal resolution, used to prefer the more detailed map
+} mapCatalogEntry;
+
+/**
+ * @brief Reads every map in a directory and builds the spatial index.
+ *
+ * Entries are kept in file name order. Sidecars whose image is missing or
+ * whose bounds are unusable are skipped with a message.
+ *
+ * @param dir Directory holding `<name>.geo` and `<name>.png` pairs
+ * @return int Number of maps found
+ */
+int mapCatalogLoad(const char *dir);
+
+/**
+ * @brief Number of maps in the catalogue.
+ */
+int mapCatalogCount();
+
+/**
+ * @brief Map at an index in file name order, or NULL.
+ */
+const mapCatalogEntry *mapCatalogEntryAt(int index);
+
+/**
+ * @brief Picks the map to show for a position.
+ *
+ * @param pos Position
+ * @param current Map shown now (may be NULL); kept until the position leaves it
+ *                unless a more detailed map covers the position
+ * @return const mapCatalogEntry* Best map covering the position, or NULL if none does
+ */
+const mapCatalogEntry *mapCatalogFind(mapCoord pos, const mapCatalogEntry *current);
+
+/**
+ * @brief Picks the map the vehicle is heading into, for preloading.
+ *
+ * Samples MAP_CATALOG_LOOKAHEAD_STEPS points along the heading, out to
+ * MAP_CATALOG_LOOKAHEAD_S seconds of travel, and returns the first one
+ * whose map differs from current.
+ *
+ * @param pos Position
+ * @param velN North velocity in mm/s
+ * @param velE East velocity in mm/s
+ * @param current Map shown now (may be NULL)
+ * @return const mapCatalogEntry* Map to preload, or NULL if none is needed
+ */
+const mapCatalogEntry *mapCatalogAhead(mapCoord pos, int32_t velN, int32_t velE, const mapCatalogEntry *current);
+
+/**
+ * @brief Frees the catalogue and its index.
+ */
+void mapCatalogFree();
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file        map_convert.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Offline converter from a map image to a memory-mappable .rawmap file.
+ *
+ * @details     Decodes the image once, converts it to the cairo format the viewer draws
+ *              from, builds the half-size pyramid and writes it all with map_raw.c. The
+ *              viewer then maps the result instead of decoding the image at startup.
+ *
+ *              Usage: `map_convert IMAGE [OUTPUT]`. OUTPUT defaults to IMAGE with its
+ *              extension replaced by .rawmap, which is where the viewer looks for it.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_cache.h"
+#include "map_raw.h"
+#include "perf_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    printf("Usage: %s IMAGE [OUTPUT%s]\n", argv[0], MAP_RAW_EXTENSION);
+    return 1;
+  }
+  const char *input = argv[1];
+  char *output = argc == 3 ? argv[2] : mapRawPathFor(input);
+
+  int64_t start = perfNowUs();
+  GdkPixbuf *pixbuf = mapPixbufLoad(input);
+  if (!pixbuf) {
+    printf("Error: cannot decode %s\n", input);
+    return 1;
+  }
+  cairo_surface_t *levels[MAP_PYRAMID_MAX_LEVELS];
+  levels[0] = mapSurfaceFromPixbuf(pixbuf);
+  g_object_unref(pixbuf);
+  if (!levels[0]) {
+    printf("Error: out of memory converting %s\n", input);
+    return 1;
+  }
+  int count = mapPyramidBuild(levels);
+  int64_t decodedUs = perfNowUs();
+
+  int status = mapRawWrite(output, levels, count);
+  if (status == 0) {
+    printf("%s -> %s: %dx%d, %d levels, decoded in %.1f ms, written in %.1f ms\n",
+           input, output, cairo_image_surface_get_width(levels[0]), cairo_image_surface_get_height(levels[0]),
+           count, (decodedUs - start) / 1000.0, (perfNowUs() - decodedUs) / 1000.0);
+  }
+
+  for (int i = 0; i < count; i++) cairo_surface_destroy(levels[i]);
+  if (output != argv[2]) free(output);
+  return status == 0 ? 0 : 1;
+}
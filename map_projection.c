@@ -0,0 +1,196 @@
+/**
+ * @file        map_projection.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Georeferenced lat/lon to map pixel projection in fixed point.
+ *
+ * @details     Both projections are reduced to "projected degrees" in 1e-7 units: easting
+ *              is the longitude itself and northing is either the latitude (equirectangular)
+ *              or the Mercator northing ln(tan(pi/4 + lat/2)) expressed in degrees. The
+ *              non-linear Mercator northing is read from a table sampled across the map's
+ *              latitude range and linearly interpolated; over a single map sheet the error is
+ *              far below a pixel. Positions outside that range fall back to the exact formula.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_projection.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Web Mercator is undefined at the poles; clamp as slippy maps do
+#define MERCATOR_MAX_LAT 85.05112878
+
+/**
+ * @brief Exact Mercator northing in 1e-7 degree units.
+ */
+static int64_t mercatorNorthing(double latDeg) {
+  if (latDeg > MERCATOR_MAX_LAT) latDeg = MERCATOR_MAX_LAT;
+  if (latDeg < -MERCATOR_MAX_LAT) latDeg = -MERCATOR_MAX_LAT;
+  double phi = latDeg * M_PI / 180.0;
+  return llround(log(tan(M_PI / 4 + phi / 2)) * 180.0 / M_PI * 1e7);
+}
+
+/**
+ * @brief Projected northing of a latitude, in 1e-7 degree units.
+ */
+static int64_t projectNorthing(const mapProjection *proj, int32_t latE7) {
+  if (proj->type == MAP_PROJECTION_EQUIRECT) return latE7;
+  if (latE7 < proj->southE7 || latE7 > proj->northE7) return mercatorNorthing(latE7 / 1e7);
+  if (latE7 == proj->northE7) return proj->northing[MAP_PROJECTION_LUT_SIZE];
+
+  int64_t pos = (int64_t)(latE7 - proj->southE7) * proj->lutScale;
+  int index = (int)(pos >> 32);
+  int64_t frac = (pos >> 16) & 0xFFFF;
+  int64_t lo = proj->northing[index];
+  int64_t hi = proj->northing[index + 1];
+  return lo + (((hi - lo) * frac) >> 16);
+}
+
+static int32_t saturate(int64_t v) {
+  if (v > INT32_MAX) return INT32_MAX;
+  if (v < INT32_MIN) return INT32_MIN;
+  return (int32_t)v;
+}
+
+int mapProjectionInit(mapProjection *proj, mapProjectionType type, double north, double south,
+                      double west, double east, int width, int height) {
+  proj->type = MAP_PROJECTION_NONE;
+  // Written as !(a > b) so NaN bounds are rejected too
+  if (type == MAP_PROJECTION_NONE || !(north > south) || !(east > west) || width <= 0 || height <= 0) return -1;
+  if (type == MAP_PROJECTION_MERCATOR && (north > MERCATOR_MAX_LAT || south < -MERCATOR_MAX_LAT)) return -1;
+
+  proj->type = type;
+  proj->width = width;
+  proj->height = height;
+  proj->north = north;
+  proj->south = south;
+  proj->west = west;
+  proj->east = east;
+  proj->northE7 = (int32_t)llround(north * 1e7);
+  proj->southE7 = (int32_t)llround(south * 1e7);
+
+  if (type == MAP_PROJECTION_MERCATOR) {
+    for (int i = 0; i <= MAP_PROJECTION_LUT_SIZE; i++) {
+      double lat = south + (north - south) * i / MAP_PROJECTION_LUT_SIZE;
+      proj->northing[i] = (int32_t)mercatorNorthing(lat);
+    }
+    proj->lutScale = ((int64_t)MAP_PROJECTION_LUT_SIZE << 32) / (proj->northE7 - proj->southE7);
+  }
+
+  // North-up image: easting maps to x, northing (decreasing) to y
+  int64_t originX = llround(west * 1e7);
+  int64_t eastX = llround(east * 1e7);
+  int64_t originY = projectNorthing(proj, proj->northE7);
+  int64_t southY = projectNorthing(proj, proj->southE7);
+  proj->originX = originX;
+  proj->originY = originY;
+  proj->xx = llround((double)width / (eastX - originX) * 4294967296.0);
+  proj->xy = 0;
+  proj->yx = 0;
+  proj->yy = -llround((double)height / (originY - southY) * 4294967296.0);
+  return 0;
+}
+
+/**
+ * @brief Strips leading and trailing whitespace in place.
+ */
+static char *trim(char *s) {
+  while (*s == ' ' || *s == '\t') s++;
+  char *end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) *--end = '\0';
+  return s;
+}
+
+int mapProjectionLoad(mapProjection *proj, const char *path, int width, int height) {
+  proj->type = MAP_PROJECTION_NONE;
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    printf("Error: cannot open map metadata %s\n", path);
+    return -1;
+  }
+
+  mapProjectionType type = MAP_PROJECTION_MERCATOR;
+  double north = NAN, south = NAN, west = NAN, east = NAN;
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    char *key = trim(line);
+    if (*key == '#' || *key == '\0') continue;
+    char *eq = strchr(key, '=');
+    if (!eq) continue;
+    *eq = '\0';
+    char *value = trim(eq + 1);
+    key = trim(key);
+
+    if (strcmp(key, "projection") == 0) {
+      if (strcmp(value, "mercator") == 0) {
+        type = MAP_PROJECTION_MERCATOR;
+      } else if (strcmp(value, "equirect") == 0) {
+        type = MAP_PROJECTION_EQUIRECT;
+      } else {
+        type = MAP_PROJECTION_NONE;
+      }
+    } else if (strcmp(key, "north") == 0) {
+      north = strtod(value, NULL);
+    } else if (strcmp(key, "south") == 0) {
+      south = strtod(value, NULL);
+    } else if (strcmp(key, "west") == 0) {
+      west = strtod(value, NULL);
+    } else if (strcmp(key, "east") == 0) {
+      east = strtod(value, NULL);
+    } else if (strcmp(key, "width") == 0) {
+      width = atoi(value);
+    } else if (strcmp(key, "height") == 0) {
+      height = atoi(value);
+    }
+  }
+  fclose(file);
+
+  // Missing bounds stay NaN and are rejected by mapProjectionInit
+  if (mapProjectionInit(proj, type, north, south, west, east, width, height) != 0) {
+    printf("Error: map metadata %s needs projection, north, south, west and east\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+bool mapProjectionValid(const mapProjection *proj) {
+  return proj->type != MAP_PROJECTION_NONE;
+}
+
+mapPoint mapProject(const mapProjection *proj, mapCoord coord) {
+  int64_t dx = (int64_t)coord.lonE7 - proj->originX;
+  int64_t dy = projectNorthing(proj, coord.latE7) - proj->originY;
+  mapPoint point;
+  point.x = saturate((proj->xx * dx + proj->xy * dy + (1 << 15)) >> 16);
+  point.y = saturate((proj->yx * dx + proj->yy * dy + (1 << 15)) >> 16);
+  return point;
+}
+
+void mapProjectBatch(const mapProjection *proj, const mapCoord *coords, mapPoint *points, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    points[i] = mapProject(proj, coords[i]);
+  }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file        map_projection.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Georeferenced lat/lon to map pixel projection in fixed point.
+ *
+ * @details     A map image is described by a sidecar file of `key=value` lines:
+ *
+ *                  # testMap.png
+ *                  projection=mercator     (or equirect)
+ *                  north=40.7812
+ *                  south=40.7411
+ *                  west=-111.9312
+ *                  east=-111.8601
+ *                  width=2053              (optional, pixels)
+ *                  height=1368             (optional, pixels)
+ *
+ *              Loading it precomputes an affine transform from projected coordinates to
+ *              pixels, plus, for Web Mercator, a table of projected northings across the
+ *              map's latitude range. Projection then takes latitude and longitude in the
+ *              receiver's native 1e-7 degree integers and returns 16.16 fixed-point pixels
+ *              using only integer multiplies, shifts and one table interpolation, so the
+ *              marker, track and any other renderer can share it cheaply, one point or a
+ *              batch at a time.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef MAP_PROJECTION_H
+#define MAP_PROJECTION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Fractional bits of projected pixel coordinates
+#define MAP_FIXED_SHIFT 16
+#define MAP_FIXED_ONE (1 << MAP_FIXED_SHIFT)
+// Whole pixels from a fixed-point coordinate (rounds toward negative infinity)
+#define MAP_FIXED_TO_INT(v) ((v) >> MAP_FIXED_SHIFT)
+// Intervals in the Web Mercator northing table
+#define MAP_PROJECTION_LUT_SIZE 256
+
+/**
+ * @brief How the map image was projected.
+ */
+typedef enum mapProjectionType {
+  MAP_PROJECTION_NONE,         // not georeferenced
+  MAP_PROJECTION_MERCATOR,     // Web Mercator (slippy map tiles, most web exports)
+  MAP_PROJECTION_EQUIRECT      // plain lat/lon grid
+} mapProjectionType;
+
+/**
+ * @brief A position as reported by the receiver, in 1e-7 degrees.
+ */
+typedef struct mapCoord {
+  int32_t latE7;
+  int32_t lonE7;
+} mapCoord;
+
+/**
+ * @brief A map position in 16.16 fixed-point pixels.
+ */
+typedef struct mapPoint {
+  int32_t x;
+  int32_t y;
+} mapPoint;
+
+/**
+ * @brief Precomputed projection for one georeferenced map image.
+ */
+typedef struct mapProjection {
+  mapProjectionType type;
+  int width;
+  int height;
+  double north, south, west, east;
+  // Projected origin (north-west corner), in 1e-7 degree units
+  int64_t originX;
+  int64_t originY;
+  // Affine from projected offsets to fixed-point pixels, scaled by 2^32
+  int64_t xx, xy, yx, yy;
+  // Mercator northings for latitudes south..north, in 1e-7 degree units
+  int32_t northing[MAP_PROJECTION_LUT_SIZE + 1];
+  int32_t southE7;
+  int32_t northE7;
+  int64_t lutScale;           // table intervals per 1e-7 degree, scaled by 2^32
+} mapProjection;
+
+/**
+ * @brief Precomputes a projection from the map's bounds.
+ *
+ * @return int 0 on success, -1 if the bounds or size are unusable
+ */
+int mapProjectionInit(mapProjection *proj, mapProjectionType type, double north, double south,
+                      double west, double east, int width, int height);
+
+/**
+ * @brief Reads a map's sidecar metadata file and precomputes its projection.
+ *
+ * @param proj Projection to fill; left as MAP_PROJECTION_NONE on failure
+ * @param path Sidecar file path
+ * @param width Image width used when the sidecar does not give one
+ * @param height Image height used when the sidecar does not give one
+ * @return int 0 on success, -1 if the file is missing or incomplete
+ */
+int mapProjectionLoad(mapProjection *proj, const char *path, int width, int height);
+
+/**
+ * @brief True if the projection has been initialised.
+ */
+bool mapProjectionValid(const mapProjection *proj);
+
+/**
+ * @brief Projects one position to fixed-point pixels.
+ */
+mapPoint mapProject(const mapProjection *proj, mapCoord coord);
+
+/**
+ * @brief Projects count positions to fixed-point pixels.
+ */
+void mapProjectBatch(const mapProjection *proj, const mapCoord *coords, mapPoint *points, size_t count);
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file        map_raw.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Writing and memory-mapping pre-decoded .rawmap files.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_raw.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief A file mapping shared by the surfaces of its levels.
+ */
+typedef struct mapRawMapping {
+  void *addr;
+  size_t length;
+  atomic_int refs;
+} mapRawMapping;
+
+static cairo_user_data_key_t mappingKey;
+
+static uint64_t alignUp(uint64_t offset) {
+  return (offset + MAP_RAW_ALIGN - 1) & ~(uint64_t)(MAP_RAW_ALIGN - 1);
+}
+
+/**
+ * @brief Surface destroy hook: unmaps the file with its last surface.
+ */
+static void releaseMapping(void *data) {
+  mapRawMapping *mapping = (mapRawMapping *)data;
+  if (atomic_fetch_sub(&mapping->refs, 1) != 1) return;
+  munmap(mapping->addr, mapping->length);
+  free(mapping);
+}
+
+/**
+ * @brief Writes len bytes at an absolute offset.
+ */
+static bool writeAt(int fd, const void *data, size_t len, uint64_t offset) {
+  const unsigned char *p = (const unsigned char *)data;
+  while (len > 0) {
+    ssize_t n = pwrite(fd, p, len, (off_t)offset);
+    if (n <= 0) return false;
+    p += n;
+    len -= (size_t)n;
+    offset += (uint64_t)n;
+  }
+  return true;
+}
+
+char *mapRawPathFor(const char *imagePath) {
+  const char *slash = strrchr(imagePath, '/');
+  const char *dot = strrchr(imagePath, '.');
+  size_t stem = (dot && (!slash || dot > slash)) ? (size_t)(dot - imagePath) : strlen(imagePath);
+  size_t len = stem + strlen(MAP_RAW_EXTENSION) + 1;
+  char *path = (char *)malloc(len);
+  snprintf(path, len, "%.*s%s", (int)stem, imagePath, MAP_RAW_EXTENSION);
+  return path;
+}
+
+int mapRawWrite(const char *path, cairo_surface_t *const *levels, int count) {
+  if (count < 1 || count > MAP_PYRAMID_MAX_LEVELS) return -1;
+  mapRawHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAP_RAW_MAGIC, sizeof(header.magic));
+  header.version = MAP_RAW_VERSION;
+  header.byteOrder = MAP_RAW_BYTE_ORDER;
+  header.format = (uint32_t)cairo_image_surface_get_format(levels[0]);
+  header.levelCount = (uint32_t)count;
+  if (header.format != CAIRO_FORMAT_ARGB32 && header.format != CAIRO_FORMAT_RGB24) {
+    printf("Error: %s: only ARGB32 and RGB24 maps can be stored\n", path);
+    return -1;
+  }
+
+  uint64_t offset = alignUp(sizeof(header));
+  for (int i = 0; i < count; i++) {
+    mapRawLevel *level = &header.levels[i];
+    level->offset = offset;
+    level->width = (uint32_t)cairo_image_surface_get_width(levels[i]);
+    level->height = (uint32_t)cairo_image_surface_get_height(levels[i]);
+    level->stride = (uint32_t)cairo_format_stride_for_width((cairo_format_t)header.format, (int)level->width);
+    offset = alignUp(offset + (uint64_t)level->stride * level->height);
+  }
+
+  size_t tmpLen = strlen(path) + 5;
+  char *tmpPath = (char *)malloc(tmpLen);
+  snprintf(tmpPath, tmpLen, "%s.tmp", path);
+  int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    printf("Error: cannot create %s\n", tmpPath);
+    free(tmpPath);
+    return -1;
+  }
+
+  bool ok = writeAt(fd, &header, sizeof(header), 0);
+  for (int i = 0; ok && i < count; i++) {
+    const mapRawLevel *level = &header.levels[i];
+    cairo_surface_flush(levels[i]);
+    const unsigned char *data = cairo_image_surface_get_data(levels[i]);
+    int srcStride = cairo_image_surface_get_stride(levels[i]);
+    for (uint32_t y = 0; ok && y < level->height; y++) {
+      ok = writeAt(fd, data + (size_t)y * srcStride, level->stride, level->offset + (uint64_t)y * level->stride);
+    }
+  }
+  // Pads the last level out to the alignment, so every level can be mapped whole
+  if (ok) ok = ftruncate(fd, (off_t)offset) == 0;
+  if (close(fd) != 0) ok = false;
+  if (ok) ok = rename(tmpPath, path) == 0;
+  if (!ok) {
+    printf("Error: failed to write %s\n", path);
+    unlink(tmpPath);
+  }
+  free(tmpPath);
+  return ok ? 0 : -1;
+}
+
+/**
+ * @brief Checks a header against the size of its file.
+ */
+static bool validHeader(const mapRawHeader *header, uint64_t fileSize) {
+  if (memcmp(header->magic, MAP_RAW_MAGIC, sizeof(header->magic)) != 0) return false;
+  if (header->version != MAP_RAW_VERSION || header->byteOrder != MAP_RAW_BYTE_ORDER) return false;
+  if (header->format != CAIRO_FORMAT_ARGB32 && header->format != CAIRO_FORMAT_RGB24) return false;
+  if (header->levelCount < 1 || header->levelCount > MAP_PYRAMID_MAX_LEVELS) return false;
+  for (uint32_t i = 0; i < header->levelCount; i++) {
+    const mapRawLevel *level = &header->levels[i];
+    if (level->width == 0 || level->height == 0 || level->width > INT32_MAX / 4) return false;
+    if (level->offset % MAP_RAW_ALIGN != 0) return false;
+    if (level->stride != (uint32_t)cairo_format_stride_for_width((cairo_format_t)header->format, (int)level->width)) return false;
+    uint64_t size = (uint64_t)level->stride * level->height;
+    if (level->offset < sizeof(*header) || level->offset > fileSize || size > fileSize - level->offset) return false;
+  }
+  return true;
+}
+
+int mapRawOpen(const char *path, cairo_surface_t **levels) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return 0;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(mapRawHeader)) {
+    close(fd);
+    return 0;
+  }
+  // Clean shared file pages: evictable, and faulted in only where drawn
+  void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return 0;
+
+  const mapRawHeader *header = (const mapRawHeader *)addr;
+  if (!validHeader(header, (uint64_t)st.st_size)) {
+    printf("Error: %s is not a valid map file\n", path);
+    munmap(addr, (size_t)st.st_size);
+    return 0;
+  }
+
+  mapRawMapping *mapping = (mapRawMapping *)malloc(sizeof(mapRawMapping));
+  mapping->addr = addr;
+  mapping->length = (size_t)st.st_size;
+  atomic_init(&mapping->refs, 1);   // held by this function until the end
+
+  int count = 0;
+  for (uint32_t i = 0; i < header->levelCount; i++) {
+    const mapRawLevel *level = &header->levels[i];
+    // cairo only reads from a surface used as a source, so the read-only mapping is safe
+    cairo_surface_t *surface = cairo_image_surface_create_for_data(
+        (unsigned char *)addr + level->offset, (cairo_format_t)header->format,
+        (int)level->width, (int)level->height, (int)level->stride);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+      cairo_surface_destroy(surface);
+      break;
+    }
+    atomic_fetch_add(&mapping->refs, 1);
+    cairo_surface_set_user_data(surface, &mappingKey, mapping, releaseMapping);
+    levels[count++] = surface;
+  }
+  releaseMapping(mapping);
+  return count;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file        map_raw.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Pre-decoded map file that is memory-mapped instead of decoded.
+ *
+ * @details     A .rawmap file holds the map and its half-size pyramid as raw cairo image
+ *              rows (premultiplied ARGB32 or RGB24, native byte order) behind a small
+ *              header. Every level starts on a page boundary with cairo's own stride, so
+ *              at runtime the file is mapped read-only and each level is wrapped straight
+ *              in cairo_image_surface_create_for_data. Opening a map then costs page faults
+ *              on the parts that are drawn instead of a PNG decode. The pages are clean and
+ *              file-backed, so the kernel can drop them under memory pressure and fault
+ *              them back in later.
+ *
+ *              Files are written by the map_convert tool (see map_convert.c). Both functions
+ *              are thread-safe.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef MAP_RAW_H
+#define MAP_RAW_H
+
+#include <stdint.h>
+#include <cairo.h>
+#include "map_cache.h"
+
+#define MAP_RAW_MAGIC "M8QRAWMP"
+#define MAP_RAW_VERSION 1
+// Written as a native uint32; reads back differently on a machine of the other byte order
+#define MAP_RAW_BYTE_ORDER 0x01020304u
+// Alignment of each level's pixels in the file
+#define MAP_RAW_ALIGN 4096
+// Extension of converted maps, replacing the image's own
+#define MAP_RAW_EXTENSION ".rawmap"
+
+/**
+ * @brief Location and geometry of one pyramid level in the file.
+ */
+typedef struct mapRawLevel {
+  uint64_t offset;     // from the start of the file, MAP_RAW_ALIGN aligned
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;     // cairo_format_stride_for_width of the level
+  uint32_t reserved;
+} mapRawLevel;
+
+/**
+ * @brief File header, at offset 0.
+ */
+typedef struct mapRawHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t format;     // cairo_format_t: CAIRO_FORMAT_ARGB32 or CAIRO_FORMAT_RGB24
+  uint32_t levelCount;
+  mapRawLevel levels[MAP_PYRAMID_MAX_LEVELS];
+} mapRawHeader;
+
+/**
+ * @brief Path of the converted file for a map image: its extension replaced
+ *        by MAP_RAW_EXTENSION (testMap.png -> testMap.rawmap).
+ *
+ * @return char* New string, freed by the caller
+ */
+char *mapRawPathFor(const char *imagePath);
+
+/**
+ * @brief Writes pyramid levels to a .rawmap file.
+ *
+ * The file is written under a temporary name and renamed into place, so a
+ * running viewer never maps a partly written file.
+ *
+ * @param path Output path
+ * @param levels Image surfaces of one format, each half the size of the one before
+ * @param count Number of levels (1..MAP_PYRAMID_MAX_LEVELS)
+ * @return int 0 on success, -1 on error (reported on stdout)
+ */
+int mapRawWrite(const char *path, cairo_surface_t *const *levels, int count);
+
+/**
+ * @brief Maps a .rawmap file and wraps its levels in image surfaces.
+ *
+ * The mapping lives until the last of the returned surfaces is destroyed.
+ * The surfaces are read-only: use them only as sources.
+ *
+ * @param path File to map
+ * @param levels Receives the level surfaces
+ * @return int Number of levels, or 0 if the file is missing or invalid
+ */
+int mapRawOpen(const char *path, cairo_surface_t **levels);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file        perf_hud.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Toggleable on-screen overlay of live render and pipeline figures.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "perf_hud.h"
+#include "perf_stats.h"
+#include "worker_pool.h"
+#include "gps_command.h"
+#include "tile_engine.h"
+#include <stdio.h>
+
+static bool hudVisible = false;
+static char hudLines[PERF_HUD_LINES][64];
+
+void perfHudSetVisible(bool visible) {
+  if (visible && !hudVisible) {
+    // Restart the live window so the first figures cover only the time shown
+    perfLive discard;
+    perfLiveSnapshot(&discard);
+    perfHudRefresh();
+  }
+  hudVisible = visible;
+}
+
+bool perfHudVisible() {
+  return hudVisible;
+}
+
+void perfHudRefresh() {
+  perfLive live;
+  perfLiveSnapshot(&live);
+  tileCacheStats tiles = {0};
+  if (tileEngineActive()) tileEngineGetStats(&tiles);
+
+  snprintf(hudLines[0], sizeof(hudLines[0]), "Draw     %6.2f ms  max %6.2f", live.drawAvgMs, live.drawMaxMs);
+  snprintf(hudLines[1], sizeof(hudLines[1]), "FPS      %6.1f", live.fps);
+  snprintf(hudLines[2], sizeof(hudLines[2]), "Read>pub %6.2f ms", live.publishLatencyMs);
+  snprintf(hudLines[3], sizeof(hudLines[3]), "Pub>draw %6.2f ms", live.paintLatencyMs);
+  if (live.readerCpu >= 0) {
+    snprintf(hudLines[4], sizeof(hudLines[4]), "Reader   %6.1f %% CPU", live.readerCpu);
+  } else {
+    snprintf(hudLines[4], sizeof(hudLines[4]), "Reader      -   CPU");
+  }
+  snprintf(hudLines[5], sizeof(hudLines[5]), "Queues   work %d  cmd %d  tile %u",
+           workerPoolPending(), gpsCommandPending(), tiles.pending);
+  if (tileEngineActive()) {
+    snprintf(hudLines[6], sizeof(hudLines[6]), "Tiles    %u  %zu KB  %s", tiles.tiles, tiles.bytes >> 10,
+             tileStorageName(tiles.storage));
+  } else {
+    snprintf(hudLines[6], sizeof(hudLines[6]), "Tiles       -");
+  }
+}
+
+void perfHudPaint(cairo_t *cr, double x, double y) {
+  if (!hudVisible) return;
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+  cairo_set_source_rgba(cr, 0, 0, 0, 0.65);
+  cairo_rectangle(cr, x, y, PERF_HUD_WIDTH, PERF_HUD_HEIGHT);
+  cairo_fill(cr);
+
+  cairo_select_font_face(cr, "Monospace", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cr, 11);
+  cairo_set_source_rgb(cr, 0.6, 1.0, 0.6);
+  for (int i = 0; i < PERF_HUD_LINES; i++) {
+    cairo_move_to(cr, x + 6, y + 4 + (i + 1) * PERF_HUD_LINE_HEIGHT - 4);
+    cairo_show_text(cr, hudLines[i]);
+  }
+  cairo_restore(cr);
+}
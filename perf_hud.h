@@ -0,0 +1,74 @@
+/**
+ * @file        perf_hud.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Toggleable on-screen overlay of live render and pipeline figures.
+ *
+ * @details     Shows, for the last PERF_HUD_REFRESH_MS, where display time goes:
+ *              - map draw time and draws per second (renderer)
+ *              - frame read to GUI publish latency (GPS link and reader)
+ *              - publish to next map draw latency (main loop and damage)
+ *              - CPU share of the reader thread
+ *              - worker, receiver command and tile decode queue depths
+ *              - decoded tile memory and its storage format
+ *
+ *              The text is formatted once per refresh, so painting the HUD is a fill and
+ *              a few cairo_show_text calls. Used from the GTK thread only.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <stdbool.h>
+#include <cairo.h>
+
+// Period of the figures and of the HUD repaint
+#define PERF_HUD_REFRESH_MS 1000
+#define PERF_HUD_LINES 7
+#define PERF_HUD_LINE_HEIGHT 15
+#define PERF_HUD_WIDTH 260
+#define PERF_HUD_HEIGHT (PERF_HUD_LINES * PERF_HUD_LINE_HEIGHT + 8)
+
+/**
+ * @brief Shows or hides the HUD. The GUI polls this to start or stop its refresh timer.
+ */
+void perfHudSetVisible(bool visible);
+
+/**
+ * @brief True while the HUD is shown.
+ */
+bool perfHudVisible();
+
+/**
+ * @brief Takes a perf snapshot and formats the HUD text from it.
+ */
+void perfHudRefresh();
+
+/**
+ * @brief Paints the HUD with its top left corner at (x, y).
+ */
+void perfHudPaint(cairo_t *cr, double x, double y);
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * @file        perf_stats.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Runtime counters for CPU, wakeup and latency measurements.
+ *
+ * @details     CPU time and context switches come from getrusage(RUSAGE_SELF), which covers
+ *              every thread in the process, so the threaded and single-threaded modes are
+ *              measured the same way. Latency is tracked with atomics because the frame
+ *              timestamp is written by the GPS reader and consumed on the GTK thread.
+ *
+ *              A second, short window feeds the on-screen HUD. It is restarted on every
+ *              perfLiveSnapshot, and the reader's CPU share there comes from its per-thread
+ *              CPU clock.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "perf_stats.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static const char *perfMode = "unknown";
+static int64_t startUs;
+static struct rusage startUsage;
+
+static atomic_llong lastFrameUs;
+static atomic_ulong framesRead;
+static unsigned long framesPublished;
+static int64_t latencySumUs;
+static int64_t latencyMaxUs;
+static atomic_ulong busTransfers;
+static atomic_ulong busBytes;
+static unsigned long draws;
+static int64_t drawSumUs;
+static int64_t drawMaxUs;
+static uint64_t paintPixels;
+static unsigned long drawHistogram[PERF_DRAW_BUCKETS];
+// Doubling ranges the histogram is summarised in (enough to cover PERF_DRAW_BUCKETS)
+#define PERF_DRAW_RANGES 16
+static unsigned long labelUpdates;
+static unsigned long commands;
+static int64_t commandSumUs;
+static int64_t commandMaxUs;
+static unsigned long recoveries;
+static int64_t recoverySumUs;
+static int64_t recoveryMaxUs;
+
+// Live window, read and reset by perfLiveSnapshot
+static int64_t liveStartUs;
+static unsigned long liveDraws;
+static int64_t liveDrawSumUs;
+static int64_t liveDrawMaxUs;
+static unsigned long livePublished;
+static int64_t liveLatencySumUs;
+static unsigned long livePainted;
+static int64_t livePaintSumUs;
+static int64_t lastPublishUs;   // publish not yet followed by a draw, 0 if none
+static clockid_t readerClock;
+static atomic_bool readerKnown;
+static int64_t liveReaderCpuUs;
+
+int64_t perfNowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t timevalUs(struct timeval tv) {
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void perfStatsStart(const char *mode) {
+  perfMode = mode;
+  atomic_store(&lastFrameUs, 0);
+  atomic_store(&framesRead, 0);
+  framesPublished = 0;
+  latencySumUs = 0;
+  latencyMaxUs = 0;
+  atomic_store(&busTransfers, 0);
+  atomic_store(&busBytes, 0);
+  draws = 0;
+  drawSumUs = 0;
+  drawMaxUs = 0;
+  paintPixels = 0;
+  memset(drawHistogram, 0, sizeof(drawHistogram));
+  labelUpdates = 0;
+  commands = 0;
+  commandSumUs = 0;
+  commandMaxUs = 0;
+  recoveries = 0;
+  recoverySumUs = 0;
+  recoveryMaxUs = 0;
+  getrusage(RUSAGE_SELF, &startUsage);
+  startUs = perfNowUs();
+}
+
+void perfNoteFrameRead() {
+  atomic_store(&lastFrameUs, perfNowUs());
+  atomic_fetch_add(&framesRead, 1);
+}
+
+void perfNotePublished() {
+  int64_t frameUs = atomic_exchange(&lastFrameUs, 0);
+  if (frameUs == 0) return;
+  int64_t now = perfNowUs();
+  int64_t latency = now - frameUs;
+  latencySumUs += latency;
+  if (latency > latencyMaxUs) latencyMaxUs = latency;
+  framesPublished++;
+  liveLatencySumUs += latency;
+  livePublished++;
+  lastPublishUs = now;
+}
+
+void perfNoteBusTransfer(uint32_t bytes) {
+  atomic_fetch_add(&busTransfers, 1);
+  atomic_fetch_add(&busBytes, bytes);
+}
+
+void perfNoteDraw(int64_t drawUs, uint64_t pixels) {
+  draws++;
+  paintPixels += pixels;
+  drawSumUs += drawUs;
+  if (drawUs > drawMaxUs) drawMaxUs = drawUs;
+  int64_t bucket = drawUs / PERF_DRAW_BUCKET_US;
+  drawHistogram[bucket < PERF_DRAW_BUCKETS ? (bucket < 0 ? 0 : bucket) : PERF_DRAW_BUCKETS - 1]++;
+
+  liveDraws++;
+  liveDrawSumUs += drawUs;
+  if (drawUs > liveDrawMaxUs) liveDrawMaxUs = drawUs;
+  if (lastPublishUs != 0) {
+    livePaintSumUs += perfNowUs() - lastPublishUs;
+    livePainted++;
+    lastPublishUs = 0;
+  }
+}
+
+void perfNoteLabelUpdate() {
+  labelUpdates++;
+}
+
+void perfNoteCommandLatency(int64_t latencyUs) {
+  commands++;
+  commandSumUs += latencyUs;
+  if (latencyUs > commandMaxUs) commandMaxUs = latencyUs;
+}
+
+void perfNoteRecovery(int64_t recoveryUs) {
+  recoveries++;
+  recoverySumUs += recoveryUs;
+  if (recoveryUs > recoveryMaxUs) recoveryMaxUs = recoveryUs;
+}
+
+/**
+ * @brief CPU time used so far by the reader thread, or -1 if unknown.
+ */
+static int64_t readerCpuUs() {
+  if (!atomic_load(&readerKnown)) return -1;
+  struct timespec ts;
+  if (clock_gettime(readerClock, &ts) != 0) return -1;
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void perfRegisterReader() {
+  if (pthread_getcpuclockid(pthread_self(), &readerClock) != 0) return;
+  atomic_store(&readerKnown, true);
+}
+
+void perfLiveSnapshot(perfLive *out) {
+  int64_t now = perfNowUs();
+  int64_t cpuUs = readerCpuUs();
+  out->seconds = liveStartUs > 0 ? (now - liveStartUs) / 1e6 : 0;
+  out->draws = liveDraws;
+  out->drawAvgMs = liveDraws > 0 ? liveDrawSumUs / 1000.0 / liveDraws : 0;
+  out->drawMaxMs = liveDrawMaxUs / 1000.0;
+  out->fps = out->seconds > 0 ? liveDraws / out->seconds : 0;
+  out->publishLatencyMs = livePublished > 0 ? liveLatencySumUs / 1000.0 / livePublished : 0;
+  out->paintLatencyMs = livePainted > 0 ? livePaintSumUs / 1000.0 / livePainted : 0;
+  out->readerCpu = -1;
+  if (cpuUs >= 0 && liveReaderCpuUs >= 0 && out->seconds > 0) {
+    out->readerCpu = 100.0 * (cpuUs - liveReaderCpuUs) / 1e6 / out->seconds;
+  }
+
+  liveStartUs = now;
+  liveReaderCpuUs = cpuUs;
+  liveDraws = 0;
+  liveDrawSumUs = 0;
+  liveDrawMaxUs = 0;
+  livePublished = 0;
+  liveLatencySumUs = 0;
+  livePainted = 0;
+  livePaintSumUs = 0;
+}
+
+/**
+ * @brief Draw time below which the given fraction of draws fell, from the histogram.
+ *
+ * @return double Upper edge of the bucket, in milliseconds
+ */
+static double drawPercentileMs(double fraction) {
+  unsigned long target = (unsigned long)ceil(fraction * draws);
+  unsigned long seen = 0;
+  for (int i = 0; i < PERF_DRAW_BUCKETS; i++) {
+    seen += drawHistogram[i];
+    if (seen >= target) return (i + 1) * PERF_DRAW_BUCKET_US / 1000.0;
+  }
+  return PERF_DRAW_BUCKETS * PERF_DRAW_BUCKET_US / 1000.0;
+}
+
+/**
+ * @brief Prints the draw time distribution as doubling ranges with a bar each.
+ */
+static void reportDrawHistogram(FILE *out) {
+  fprintf(out, "  Draw time:   p50 %.2f ms, p90 %.2f ms, p99 %.2f ms\n",
+          drawPercentileMs(0.50), drawPercentileMs(0.90), drawPercentileMs(0.99));
+
+  // Ranges of 0-0.1 ms, 0.1-0.2, 0.2-0.4, ... with the last one ending at the top bucket
+  int edges[PERF_DRAW_RANGES + 1] = {0};
+  unsigned long counts[PERF_DRAW_RANGES] = {0};
+  unsigned long peak = 0;
+  int ranges = 0;
+  for (int hi = 2; edges[ranges] < PERF_DRAW_BUCKETS && ranges < PERF_DRAW_RANGES; hi *= 2) {
+    edges[ranges + 1] = hi < PERF_DRAW_BUCKETS ? hi : PERF_DRAW_BUCKETS;
+    for (int i = edges[ranges]; i < edges[ranges + 1]; i++) counts[ranges] += drawHistogram[i];
+    if (counts[ranges] > peak) peak = counts[ranges];
+    ranges++;
+  }
+
+  for (int r = 0; r < ranges; r++) {
+    if (counts[r] == 0) continue;
+    char bar[41];
+    int len = (int)(40 * counts[r] / peak);
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    fprintf(out, "    %5.1f-%-5.1f ms %7lu %s\n", edges[r] * PERF_DRAW_BUCKET_US / 1000.0,
+            edges[r + 1] * PERF_DRAW_BUCKET_US / 1000.0, counts[r], bar);
+  }
+}
+
+void perfStatsReport(FILE *out) {
+  struct rusage now;
+  getrusage(RUSAGE_SELF, &now);
+  double elapsed = (perfNowUs() - startUs) / 1e6;
+  if (elapsed <= 0) return;
+
+  int64_t cpuUs = (timevalUs(now.ru_utime) - timevalUs(startUsage.ru_utime)) +
+                  (timevalUs(now.ru_stime) - timevalUs(startUsage.ru_stime));
+  long switches = (now.ru_nvcsw - startUsage.ru_nvcsw) + (now.ru_nivcsw - startUsage.ru_nivcsw);
+
+  fprintf(out, "=== PERF [%s] over %.1f s ===\n", perfMode, elapsed);
+  fprintf(out, "  CPU:         %.2f %%\n", 100.0 * cpuUs / 1e6 / elapsed);
+  fprintf(out, "  Wakeups/s:   %.1f\n", switches / elapsed);
+  fprintf(out, "  Frames:      %lu read, %lu published\n", atomic_load(&framesRead), framesPublished);
+  if (framesPublished > 0) {
+    fprintf(out, "  Latency:     avg %.3f ms, max %.3f ms\n",
+            latencySumUs / 1000.0 / framesPublished, latencyMaxUs / 1000.0);
+  }
+  if (draws > 0) {
+    fprintf(out, "  Draws:       %lu, avg %.3f ms, max %.3f ms\n",
+            draws, drawSumUs / 1000.0 / draws, drawMaxUs / 1000.0);
+    fprintf(out, "  Paint:       %.0f px/draw, %.0f px/fix\n",
+            (double)paintPixels / draws, framesPublished > 0 ? (double)paintPixels / framesPublished : 0.0);
+    reportDrawHistogram(out);
+  }
+  fprintf(out, "  Labels:      %.1f relayouts/s\n", labelUpdates / elapsed);
+  fprintf(out, "  Bus:         %.1f transfers/s, %.0f bytes/s\n",
+          atomic_load(&busTransfers) / elapsed, atomic_load(&busBytes) / elapsed);
+  if (commands > 0) {
+    fprintf(out, "  Commands:    %lu, queue to ACK avg %.1f ms, max %.1f ms\n",
+            commands, commandSumUs / 1000.0 / commands, commandMaxUs / 1000.0);
+  }
+  if (recoveries > 0) {
+    fprintf(out, "  Recoveries:  %lu, avg %.1f ms, max %.1f ms\n",
+            recoveries, recoverySumUs / 1000.0 / recoveries, recoveryMaxUs / 1000.0);
+  }
+}
@@ -0,0 +1,149 @@
+/**
+ * @file        perf_stats.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Lightweight runtime counters for comparing execution modes.
+ *
+ * @details     Collects the figures used to compare the threaded and single-threaded
+ *              event loop modes: process CPU usage, context switches (wakeups) per second,
+ *              and the latency from a UBX frame finishing on the bus to the GUI being
+ *              updated with it. Map draw times, bus transactions, command round trips
+ *              and receiver outage recovery times are recorded as well.
+ *              Counters are cheap enough to leave enabled.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Resolution and range of the draw time histogram; slower draws share the last bucket
+#define PERF_DRAW_BUCKET_US 50
+#define PERF_DRAW_BUCKETS 2000
+
+/**
+ * @brief Figures for the window since the previous perfLiveSnapshot call.
+ */
+typedef struct perfLive {
+  double seconds;            // length of the window
+  unsigned long draws;
+  double drawAvgMs;
+  double drawMaxMs;
+  double fps;                // map draws per second
+  double publishLatencyMs;   // frame read to GUI publish, average
+  double paintLatencyMs;     // GUI publish to the next map draw, average
+  double readerCpu;          // % of one core used by the reader, -1 if unknown
+} perfLive;
+
+/**
+ * @brief Returns a CLOCK_MONOTONIC timestamp in microseconds.
+ */
+int64_t perfNowUs();
+
+/**
+ * @brief Resets all counters and records the start of a measurement window.
+ *
+ * @param mode Label printed in the report (e.g. "threaded" or "loop")
+ */
+void perfStatsStart(const char *mode);
+
+/**
+ * @brief Records that a UBX frame has been fully read from the receiver.
+ *
+ * Called from whichever thread owns the transport.
+ */
+void perfNoteFrameRead();
+
+/**
+ * @brief Records that the GUI has consumed the most recent frame.
+ *
+ * Called on the GTK thread; accumulates read-to-publish latency.
+ */
+void perfNotePublished();
+
+/**
+ * @brief Records the time spent in one map draw handler call.
+ *
+ * Called on the GTK (or rendering) thread.
+ *
+ * @param drawUs Time spent in the handler
+ * @param paintPixels Area of the clip the handler was asked to repaint
+ */
+void perfNoteDraw(int64_t drawUs, uint64_t paintPixels);
+
+/**
+ * @brief Records one label whose text was changed, each costing a relayout.
+ *
+ * Called on the GTK thread.
+ */
+void perfNoteLabelUpdate();
+
+/**
+ * @brief Records one bus transaction with the receiver.
+ *
+ * Called by the transport for every transfer, whatever its size.
+ *
+ * @param bytes Bytes clocked in the transaction
+ */
+void perfNoteBusTransfer(uint32_t bytes);
+
+/**
+ * @brief Records the time from queueing a receiver command to its ACK/NACK.
+ *
+ * Called from whichever thread owns the transport.
+ */
+void perfNoteCommandLatency(int64_t latencyUs);
+
+/**
+ * @brief Records how long the receiver took to recover from an outage.
+ *
+ * @param recoveryUs Time from the first missed epoch to the next valid one
+ */
+void perfNoteRecovery(int64_t recoveryUs);
+
+/**
+ * @brief Marks the calling thread as the one reading the receiver, for its CPU figure.
+ *
+ * Called by the GPS thread, or by the GTK thread when the loop mode reads there.
+ */
+void perfRegisterReader();
+
+/**
+ * @brief Fills in the live figures and starts a new window.
+ *
+ * Called on the GTK thread. Independent of the perfStatsStart window.
+ */
+void perfLiveSnapshot(perfLive *out);
+
+/**
+ * @brief Prints CPU%, wakeups/s, publish latency and the draw time
+ *        distribution for the current window.
+ *
+ * @param out Stream to print to
+ */
+void perfStatsReport(FILE *out);
+
+#endif
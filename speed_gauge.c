@@ -0,0 +1,192 @@
+/**
+ * @file        speed_gauge.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Speedometer drawing with a dial rendered once per size.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "speed_gauge.h"
+#include <math.h>
+#include <stdio.h>
+
+// Needle sweep: 0 mph at lower left, full scale at lower right, clockwise
+#define GAUGE_START_ANGLE (0.75 * M_PI)
+#define GAUGE_SWEEP (1.5 * M_PI)
+
+/**
+ * @brief Angle of the needle at a speed, clamped to the scale.
+ */
+static double speedAngle(double mph) {
+  if (mph < 0) mph = 0;
+  if (mph > SPEED_GAUGE_MAX_MPH) mph = SPEED_GAUGE_MAX_MPH;
+  return GAUGE_START_ANGLE + GAUGE_SWEEP * mph / SPEED_GAUGE_MAX_MPH;
+}
+
+/**
+ * @brief Renders the static face for a size: face, ring, ticks, numbers and unit.
+ */
+static cairo_surface_t *buildDial(int size) {
+  cairo_surface_t *dial = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+  if (cairo_surface_status(dial) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(dial);
+    return NULL;
+  }
+  cairo_t *cr = cairo_create(dial);
+  double c = size / 2.0;
+  double r = c - 2;
+
+  cairo_arc(cr, c, c, r, 0, 2 * M_PI);
+  cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+  cairo_fill_preserve(cr);
+  cairo_set_line_width(cr, 2);
+  cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
+  cairo_stroke(cr);
+
+  cairo_set_source_rgb(cr, 1, 1, 1);
+  cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cr, size * 0.075);
+  for (int mph = 0; mph <= SPEED_GAUGE_MAX_MPH; mph += SPEED_GAUGE_MINOR_MPH) {
+    bool major = mph % SPEED_GAUGE_MAJOR_MPH == 0;
+    double a = speedAngle(mph);
+    double inner = r * (major ? 0.82 : 0.88);
+    cairo_set_line_width(cr, major ? 2.5 : 1);
+    cairo_move_to(cr, c + inner * cos(a), c + inner * sin(a));
+    cairo_line_to(cr, c + (r - 3) * cos(a), c + (r - 3) * sin(a));
+    cairo_stroke(cr);
+    if (!major) continue;
+
+    char text[8];
+    snprintf(text, sizeof(text), "%d", mph);
+    cairo_text_extents_t extents;
+    cairo_text_extents(cr, text, &extents);
+    double tx = c + r * 0.66 * cos(a);
+    double ty = c + r * 0.66 * sin(a);
+    cairo_move_to(cr, tx - extents.width / 2 - extents.x_bearing, ty - extents.height / 2 - extents.y_bearing);
+    cairo_show_text(cr, text);
+  }
+
+  cairo_set_font_size(cr, size * 0.07);
+  cairo_text_extents_t extents;
+  cairo_text_extents(cr, "mph", &extents);
+  cairo_move_to(cr, c - extents.width / 2 - extents.x_bearing, c + r * 0.72);
+  cairo_show_text(cr, "mph");
+  cairo_destroy(cr);
+  return dial;
+}
+
+bool speedGaugeSet(speedGauge *gauge, int mph, int64_t nowUs) {
+  gauge->digitsMph = mph;
+  gauge->targetMph = mph;
+  if (fabs(gauge->targetMph - gauge->shownMph) < SPEED_GAUGE_SNAP_MPH) return gauge->moving;
+  if (!gauge->moving) gauge->stepUs = nowUs;
+  gauge->moving = true;
+  return true;
+}
+
+bool speedGaugeStep(speedGauge *gauge, int64_t nowUs) {
+  if (!gauge->moving) return false;
+  int64_t elapsedUs = nowUs - gauge->stepUs;
+  gauge->stepUs = nowUs;
+  if (elapsedUs <= 0) return true;
+
+  double k = 1.0 - exp(-elapsedUs / (SPEED_GAUGE_EASE_MS * 1000.0));
+  gauge->shownMph += (gauge->targetMph - gauge->shownMph) * k;
+  if (fabs(gauge->targetMph - gauge->shownMph) < SPEED_GAUGE_SNAP_MPH) {
+    gauge->shownMph = gauge->targetMph;
+    gauge->moving = false;
+  }
+  return gauge->moving;
+}
+
+void speedGaugePaint(speedGauge *gauge, cairo_t *cr, int x, int y, int size) {
+  if (size <= 0) return;
+  if (!gauge->dial || gauge->size != size) {
+    speedGaugeFree(gauge);
+    gauge->dial = buildDial(size);
+  }
+  gauge->x = x;
+  gauge->y = y;
+  gauge->size = size;
+  if (!gauge->dial) return;
+
+  cairo_save(cr);
+  cairo_set_source_surface(cr, gauge->dial, x, y);
+  cairo_paint(cr);
+
+  double c = size / 2.0;
+  double a = speedAngle(gauge->shownMph);
+  double length = (c - 2) * 0.8;
+  cairo_set_line_width(cr, size / 40.0);
+  cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+  cairo_set_source_rgb(cr, 0.95, 0.25, 0.15);
+  cairo_move_to(cr, x + c, y + c);
+  cairo_line_to(cr, x + c + length * cos(a), y + c + length * sin(a));
+  cairo_stroke(cr);
+  cairo_arc(cr, x + c, y + c, size / 20.0, 0, 2 * M_PI);
+  cairo_set_source_rgb(cr, 0.7, 0.7, 0.7);
+  cairo_fill(cr);
+
+  char text[8];
+  snprintf(text, sizeof(text), "%d", gauge->digitsMph);
+  cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+  cairo_set_font_size(cr, size * 0.16);
+  cairo_text_extents_t extents;
+  cairo_text_extents(cr, text, &extents);
+  cairo_set_source_rgb(cr, 1, 1, 1);
+  cairo_move_to(cr, x + c - extents.width / 2 - extents.x_bearing, y + c + size * 0.27);
+  cairo_show_text(cr, text);
+  cairo_restore(cr);
+}
+
+void speedGaugeNeedleBounds(const speedGauge *gauge, double mph, cairo_rectangle_int_t *rect) {
+  double c = gauge->size / 2.0;
+  double a = speedAngle(mph);
+  double length = (c - 2) * 0.8;
+  double tipX = c + length * cos(a);
+  double tipY = c + length * sin(a);
+  // Hub radius covers the round cap and the centre end of the needle
+  double pad = gauge->size / 20.0 + 1;
+  int x1 = (int)floor(fmin(c, tipX) - pad);
+  int y1 = (int)floor(fmin(c, tipY) - pad);
+  int x2 = (int)ceil(fmax(c, tipX) + pad);
+  int y2 = (int)ceil(fmax(c, tipY) + pad);
+  rect->x = gauge->x + x1;
+  rect->y = gauge->y + y1;
+  rect->width = x2 - x1;
+  rect->height = y2 - y1;
+}
+
+void speedGaugeDigitsBounds(const speedGauge *gauge, cairo_rectangle_int_t *rect) {
+  // Bold digits at 0.16 * size fit in half the width, from 0.1 to 0.32 below centre
+  rect->x = gauge->x + gauge->size / 4;
+  rect->y = gauge->y + (int)floor(gauge->size * 0.6);
+  rect->width = gauge->size / 2 + 1;
+  rect->height = (int)ceil(gauge->size * 0.22);
+}
+
+void speedGaugeFree(speedGauge *gauge) {
+  if (gauge->dial) cairo_surface_destroy(gauge->dial);
+  gauge->dial = NULL;
+}
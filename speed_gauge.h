@@ -0,0 +1,113 @@
+/**
+ * @file        speed_gauge.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Round speedometer with a cached dial and an eased needle.
+ *
+ * @details     The static face (ring, ticks, numbers, unit) is rendered once per size into
+ *              an image surface. A frame blits the dial under the clip and strokes only the
+ *              needle, hub and digits on top. speedGaugeNeedleBounds and
+ *              speedGaugeDigitsBounds give the boxes that change, so callers can damage
+ *              just those instead of the whole gauge.
+ *
+ *              A new speed is not jumped to. The needle eases towards it with time constant
+ *              SPEED_GAUGE_EASE_MS, stepped on the display's frame clock, so it sweeps
+ *              smoothly between 1 Hz fixes. Used from the GTK thread (or the offscreen loop)
+ *              only. Times are monotonic microseconds.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef SPEED_GAUGE_H
+#define SPEED_GAUGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cairo.h>
+
+// Preferred gauge size in pixels
+#define SPEED_GAUGE_SIZE 160
+// Full-scale speed and the tick spacing
+#define SPEED_GAUGE_MAX_MPH 80
+#define SPEED_GAUGE_MAJOR_MPH 10
+#define SPEED_GAUGE_MINOR_MPH 2
+// Time constant of the needle's ease towards a new speed
+#define SPEED_GAUGE_EASE_MS 250
+// Closer than this the needle lands on the speed
+#define SPEED_GAUGE_SNAP_MPH 0.05
+
+/**
+ * @brief Gauge state and its cached dial.
+ */
+typedef struct speedGauge {
+  double shownMph;          // needle position now
+  double targetMph;         // speed being eased to
+  int digitsMph;            // speed in the digits
+  bool moving;
+  int64_t stepUs;           // time of the last step
+  cairo_surface_t *dial;    // static face at the last painted size
+  int x;                    // square last painted in
+  int y;
+  int size;                 // 0 until first painted
+} speedGauge;
+
+/**
+ * @brief Sets the speed to show. The digits change at once, the needle eases.
+ *
+ * @return bool True if the needle needs speedGaugeStep every frame
+ */
+bool speedGaugeSet(speedGauge *gauge, int mph, int64_t nowUs);
+
+/**
+ * @brief Advances the needle to nowUs.
+ *
+ * @return bool True while the needle is still moving
+ */
+bool speedGaugeStep(speedGauge *gauge, int64_t nowUs);
+
+/**
+ * @brief Paints the gauge in a square, rebuilding the dial first if the size changed.
+ *
+ * @param cr Cairo context, clipped to what needs painting
+ * @param x Left of the square
+ * @param y Top of the square
+ * @param size Side of the square in pixels
+ */
+void speedGaugePaint(speedGauge *gauge, cairo_t *cr, int x, int y, int size);
+
+/**
+ * @brief Box covering the needle and hub at a speed, in the last painted square.
+ */
+void speedGaugeNeedleBounds(const speedGauge *gauge, double mph, cairo_rectangle_int_t *rect);
+
+/**
+ * @brief Box covering the digits, in the last painted square.
+ */
+void speedGaugeDigitsBounds(const speedGauge *gauge, cairo_rectangle_int_t *rect);
+
+/**
+ * @brief Releases the cached dial.
+ */
+void speedGaugeFree(speedGauge *gauge);
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * @file        tile_build.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Offline tool: cuts a georeferenced map image into a z/x/y tile pyramid.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "map_cache.h"
+#include "map_raw.h"
+#include "map_projection.h"
+#include "tile_engine.h"
+#include "perf_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Upper bound on render threads regardless of core count
+#define TILE_BUILD_MAX_THREADS 64
+
+/**
+ * @brief One output tile.
+ */
+typedef struct buildTile {
+  int z;
+  int x;
+  int y;
+} buildTile;
+
+static mapProjection proj;
+static cairo_surface_t *levels[MAP_PYRAMID_MAX_LEVELS];
+static int levelCount;
+static const char *outDir;
+
+// The work queue: every tile of every level, handed out in order by one atomic cursor
+static buildTile *tiles;
+static size_t tileCount;
+static atomic_size_t nextTile;
+static atomic_int failures;
+
+/**
+ * @brief Web Mercator x of a longitude, in pixels of a world worldSize pixels wide.
+ */
+static double worldX(double lon, double worldSize) {
+  return worldSize * (lon + 180.0) / 360.0;
+}
+
+/**
+ * @brief Web Mercator y of a latitude, in pixels of a world worldSize pixels high.
+ */
+static double worldY(double lat, double worldSize) {
+  double rad = lat * M_PI / 180.0;
+  return worldSize * (0.5 - log(tan(M_PI / 4 + rad / 2)) / (2 * M_PI));
+}
+
+/**
+ * @brief Latitude of a Web Mercator y, the inverse of worldY.
+ */
+static double latitudeAt(double y, double worldSize) {
+  return atan(sinh(M_PI * (1.0 - 2.0 * y / worldSize))) * 180.0 / M_PI;
+}
+
+/**
+ * @brief Renders one tile from the source pyramid.
+ *
+ * Longitude is linear in both the image and the tile, so x is a plain scale
+ * and offset. A Mercator image is linear in y too and is drawn with one
+ * affine paint. An equirectangular image is drawn one row at a time, each
+ * row with its own y scale.
+ */
+static void renderTile(const buildTile *t, cairo_surface_t *tile) {
+  double world = TILE_SIZE * (double)(1 << t->z);
+  // Source pixels per tile pixel, horizontally
+  double scale = proj.width * 360.0 / ((proj.east - proj.west) * world);
+
+  // Same rule as mapCachePaint: the smallest level that still has the detail
+  int level = 0;
+  while (level + 1 < levelCount && (double)(1 << (level + 1)) <= scale) level++;
+  cairo_surface_t *src = levels[level];
+  double levelX = cairo_image_surface_get_width(src) / (double)proj.width;
+  double levelY = cairo_image_surface_get_height(src) / (double)proj.height;
+
+  double left = (double)t->x * TILE_SIZE;
+  double top = (double)t->y * TILE_SIZE;
+  double xx = scale * levelX;
+  double x0 = (left - worldX(proj.west, world)) * xx;
+
+  cairo_t *cr = cairo_create(tile);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  cairo_pattern_t *pattern = cairo_pattern_create_for_surface(src);
+  cairo_pattern_set_filter(pattern, CAIRO_FILTER_BILINEAR);
+  cairo_matrix_t matrix;
+
+  if (proj.type == MAP_PROJECTION_MERCATOR) {
+    double north = worldY(proj.north, world);
+    double yy = proj.height / (worldY(proj.south, world) - north) * levelY;
+    cairo_matrix_init(&matrix, xx, 0, 0, yy, x0, (top - north) * yy);
+    cairo_pattern_set_matrix(pattern, &matrix);
+    cairo_set_source(cr, pattern);
+    cairo_paint(cr);
+  } else {
+    double rowScale = proj.height / (proj.north - proj.south) * levelY;
+    for (int v = 0; v < TILE_SIZE; v++) {
+      double y = top + v + 0.5;
+      double sy = (proj.north - latitudeAt(y, world)) * rowScale;
+      double yy = (latitudeAt(y - 0.5, world) - latitudeAt(y + 0.5, world)) * rowScale;
+      cairo_matrix_init(&matrix, xx, 0, 0, yy, x0, sy - yy * (v + 0.5));
+      cairo_pattern_set_matrix(pattern, &matrix);
+      cairo_set_source(cr, pattern);
+      cairo_rectangle(cr, 0, v, TILE_SIZE, 1);
+      cairo_fill(cr);
+    }
+  }
+  cairo_pattern_destroy(pattern);
+  cairo_destroy(cr);
+  cairo_surface_flush(tile);
+}
+
+/**
+ * @brief Render thread: takes tiles off the queue until it is empty.
+ */
+static void *buildWorker(void *arg) {
+  (void)arg;
+  // One scratch tile per thread; every pixel is overwritten for each tile
+  cairo_surface_t *tile = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, TILE_SIZE, TILE_SIZE);
+  char path[1024];
+  for (;;) {
+    size_t i = atomic_fetch_add(&nextTile, 1);
+    if (i >= tileCount) break;
+    const buildTile *t = &tiles[i];
+    renderTile(t, tile);
+    snprintf(path, sizeof(path), "%s/%d/%d/%d.png", outDir, t->z, t->x, t->y);
+    if (cairo_surface_write_to_png(tile, path) != CAIRO_STATUS_SUCCESS) {
+      printf("Error: cannot write %s\n", path);
+      atomic_fetch_add(&failures, 1);
+    }
+  }
+  cairo_surface_destroy(tile);
+  return NULL;
+}
+
+/**
+ * @brief Tile column and row ranges covering the image at one zoom.
+ */
+static void tileRange(int z, int *xLo, int *xHi, int *yLo, int *yHi) {
+  double world = TILE_SIZE * (double)(1 << z);
+  int last = (1 << z) - 1;
+  *xLo = (int)floor(worldX(proj.west, world) / TILE_SIZE);
+  *xHi = (int)ceil(worldX(proj.east, world) / TILE_SIZE) - 1;
+  *yLo = (int)floor(worldY(proj.north, world) / TILE_SIZE);
+  *yHi = (int)ceil(worldY(proj.south, world) / TILE_SIZE) - 1;
+  if (*xLo < 0) *xLo = 0;
+  if (*yLo < 0) *yLo = 0;
+  if (*xHi > last) *xHi = last;
+  if (*yHi > last) *yHi = last;
+}
+
+/**
+ * @brief Lists every tile from minZoom to maxZoom and creates their directories.
+ *
+ * @return int 0 on success, -1 if a directory cannot be created
+ */
+static int planTiles(int minZoom, int maxZoom) {
+  size_t capacity = 0;
+  for (int z = minZoom; z <= maxZoom; z++) {
+    int xLo, xHi, yLo, yHi;
+    tileRange(z, &xLo, &xHi, &yLo, &yHi);
+    capacity += (size_t)(xHi - xLo + 1) * (size_t)(yHi - yLo + 1);
+  }
+  tiles = (buildTile *)malloc(capacity * sizeof(buildTile));
+  if (!tiles) return -1;
+
+  char path[1024];
+  for (int z = minZoom; z <= maxZoom; z++) {
+    int xLo, xHi, yLo, yHi;
+    tileRange(z, &xLo, &xHi, &yLo, &yHi);
+    // Column-major, so neighbouring tiles are handed to threads at about the same time
+    for (int x = xLo; x <= xHi; x++) {
+      snprintf(path, sizeof(path), "%s/%d/%d", outDir, z, x);
+      if (g_mkdir_with_parents(path, 0755) != 0) {
+        printf("Error: cannot create %s\n", path);
+        return -1;
+      }
+      for (int y = yLo; y <= yHi; y++) {
+        tiles[tileCount++] = (buildTile){z, x, y};
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Writes the pack's bounds, centre and zoom range for tileEngineOpen.
+ *
+ * Same keys and value formats as the MBTiles metadata table.
+ */
+static int writeMetadata(const char *name, int minZoom, int maxZoom) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s", outDir, TILE_METADATA_FILE);
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    printf("Error: cannot write %s\n", path);
+    return -1;
+  }
+  fprintf(file, "name=%s\n", name);
+  fprintf(file, "format=png\n");
+  fprintf(file, "bounds=%.7f,%.7f,%.7f,%.7f\n", proj.west, proj.south, proj.east, proj.north);
+  fprintf(file, "center=%.7f,%.7f,%d\n", (proj.west + proj.east) / 2, (proj.south + proj.north) / 2, maxZoom);
+  fprintf(file, "minzoom=%d\n", minZoom);
+  fprintf(file, "maxzoom=%d\n", maxZoom);
+  fclose(file);
+  return 0;
+}
+
+/**
+ * @brief Loads the image and its pyramid, from the .rawmap if that is current.
+ *
+ * @return int 0 on success, -1 if the image cannot be read
+ */
+static int loadSource(const char *image) {
+  char *rawPath = mapRawPathFor(image);
+  struct stat imageInfo, rawInfo;
+  if (stat(rawPath, &rawInfo) == 0 && (stat(image, &imageInfo) != 0 || rawInfo.st_mtime >= imageInfo.st_mtime)) {
+    levelCount = mapRawOpen(rawPath, levels);
+  }
+  free(rawPath);
+  if (levelCount > 0) return 0;
+
+  GdkPixbuf *pixbuf = mapPixbufLoad(image);
+  if (!pixbuf) {
+    printf("Error: cannot decode %s\n", image);
+    return -1;
+  }
+  levels[0] = mapSurfaceFromPixbuf(pixbuf);
+  g_object_unref(pixbuf);
+  if (!levels[0]) {
+    printf("Error: out of memory converting %s\n", image);
+    return -1;
+  }
+  levelCount = mapPyramidBuild(levels);
+  return 0;
+}
+
+/**
+ * @brief Replaces the extension of path (or appends one), like mapRawPathFor.
+ */
+static char *siblingPath(const char *path, const char *extension) {
+  const char *slash = strrchr(path, '/');
+  const char *dot = strrchr(path, '.');
+  size_t stem = (dot && (!slash || dot > slash)) ? (size_t)(dot - path) : strlen(path);
+  return g_strdup_printf("%.*s%s", (int)stem, path, extension);
+}
+
+static void usage(const char *name) {
+  printf("Usage: %s IMAGE OUTDIR [options]\n"
+         "  --geo=FILE          Bounds sidecar (default IMAGE with a .geo extension)\n"
+         "  --bounds=W,S,E,N    Bounds in degrees instead of a sidecar (GeoJSON bbox order)\n"
+         "  --projection=P      mercator (default) or equirect, with --bounds\n"
+         "  --min-zoom=N        Shallowest level (default: the image fits in about one tile)\n"
+         "  --max-zoom=N        Deepest level (default: the image's own resolution)\n"
+         "  --threads=N         Render threads (default: one per online core)\n", name);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    usage(argv[0]);
+    return 1;
+  }
+  const char *image = argv[1];
+  outDir = argv[2];
+  char *geoPath = NULL;
+  double west = NAN, south = NAN, east = NAN, north = NAN;
+  mapProjectionType type = MAP_PROJECTION_MERCATOR;
+  int minZoom = -1, maxZoom = -1;
+  int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 3; i < argc; i++) {
+    if (strncmp(argv[i], "--geo=", 6) == 0) {
+      g_free(geoPath);
+      geoPath = g_strdup(argv[i] + 6);
+    } else if (strncmp(argv[i], "--bounds=", 9) == 0) {
+      if (sscanf(argv[i] + 9, "%lf,%lf,%lf,%lf", &west, &south, &east, &north) != 4) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--projection=mercator") == 0) {
+      type = MAP_PROJECTION_MERCATOR;
+    } else if (strcmp(argv[i], "--projection=equirect") == 0) {
+      type = MAP_PROJECTION_EQUIRECT;
+    } else if (strncmp(argv[i], "--min-zoom=", 11) == 0) {
+      minZoom = atoi(argv[i] + 11);
+    } else if (strncmp(argv[i], "--max-zoom=", 11) == 0) {
+      maxZoom = atoi(argv[i] + 11);
+    } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+      threads = atoi(argv[i] + 10);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int64_t start = perfNowUs();
+  if (loadSource(image) != 0) return 1;
+  int width = cairo_image_surface_get_width(levels[0]);
+  int height = cairo_image_surface_get_height(levels[0]);
+
+  // The sidecar is only read for its bounds; the image itself gives the size
+  int status;
+  if (!isnan(west)) {
+    status = mapProjectionInit(&proj, type, north, south, west, east, width, height);
+  } else {
+    if (!geoPath) geoPath = siblingPath(image, ".geo");
+    status = mapProjectionLoad(&proj, geoPath, width, height);
+    if (status == 0) {
+      status = mapProjectionInit(&proj, proj.type, proj.north, proj.south, proj.west, proj.east, width, height);
+    }
+  }
+  g_free(geoPath);
+  if (status != 0) {
+    printf("Error: no usable bounds for %s (use a .geo sidecar or --bounds=W,S,E,N)\n", image);
+    return 1;
+  }
+
+  // Deepest level: the first whose pixels are no larger than the image's
+  double perTile = proj.width * 360.0 / ((proj.east - proj.west) * TILE_SIZE);
+  if (maxZoom < 0) maxZoom = (int)ceil(log2(perTile));
+  if (maxZoom > TILE_MAX_ZOOM) maxZoom = TILE_MAX_ZOOM;
+  if (maxZoom < 0) maxZoom = 0;
+  if (minZoom < 0) {
+    int longest = width > height ? width : height;
+    minZoom = maxZoom - (int)ceil(log2(longest / (double)TILE_SIZE));
+  }
+  if (minZoom < 0) minZoom = 0;
+  if (minZoom > maxZoom) minZoom = maxZoom;
+  if (threads < 1) threads = 1;
+  if (threads > TILE_BUILD_MAX_THREADS) threads = TILE_BUILD_MAX_THREADS;
+
+  if (planTiles(minZoom, maxZoom) != 0) return 1;
+  int64_t loadedUs = perfNowUs();
+
+  pthread_t workers[TILE_BUILD_MAX_THREADS];
+  int started = 0;
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&workers[started], NULL, buildWorker, NULL) == 0) started++;
+  }
+  // With no threads at all, render on this one
+  if (started == 0) buildWorker(NULL);
+  for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+  char *name = g_path_get_basename(image);
+  if (writeMetadata(name, minZoom, maxZoom) != 0) atomic_fetch_add(&failures, 1);
+  g_free(name);
+
+  double renderSeconds = (perfNowUs() - loadedUs) / 1e6;
+  printf("%s -> %s: %dx%d, zoom %d-%d, %zu tiles, %d threads, loaded in %.1f ms, tiled in %.2f s "
+         "(%.0f tiles/s)\n", image, outDir, width, height, minZoom, maxZoom, tileCount, started ? started : 1,
+         (loadedUs - start) / 1000.0, renderSeconds, renderSeconds > 0 ? tileCount / renderSeconds : 0.0);
+
+  for (int i = 0; i < levelCount; i++) cairo_surface_destroy(levels[i]);
+  free(tiles);
+  return atomic_load(&failures) == 0 ? 0 : 1;
+}
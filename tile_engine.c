@@ -0,0 +1,678 @@
+/**
+ * @file        tile_engine.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       z/x/y map tile engine with a memory-bounded LRU cache of decoded tiles.
+ *
+ * @details     Cache entries are indexed by a packed z/x/y key in a GHashTable and linked
+ *              into a GQueue in recency order (head = most recently used). Each entry
+ *              embeds its own queue link, so a hit is an O(1) unlink/push and eviction pops
+ *              from the tail until the byte budget is met again. Tiles drawn in the current
+ *              frame are never evicted by that frame, even if the budget is smaller than a
+ *              screenful.
+ *
+ *              A miss never decodes on the GTK thread: it indexes a pending entry and
+ *              queues the read and decode on the worker pool. Until the tile lands the
+ *              draw shows the matching corner of a cached lower-zoom tile, scaled up, or
+ *              a flat fill.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "tile_engine.h"
+#include "map_cache.h"
+#include "worker_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#ifdef USE_MBTILES
+#include <sqlite3.h>
+#endif
+
+/**
+ * @brief One cached tile. surface is NULL for tiles the pack does not contain.
+ *
+ * Entries whose decode is still running on the worker pool are pending: they are
+ * indexed, so the tile is not queued twice, but kept out of the LRU queue so they
+ * cannot be evicted under the job.
+ */
+typedef struct tileEntry {
+  gint64 key;
+  cairo_surface_t *surface;
+  size_t bytes;
+  unsigned int frame;   // last frame that drew this tile
+  bool pending;         // decode in flight
+  GList link;           // position in the LRU queue, data points back to the entry
+} tileEntry;
+
+/**
+ * @brief One background tile decode.
+ */
+typedef struct tileDecodeJob {
+  int z, x, y;
+  unsigned int generation;   // source the job was queued for
+  tileStorage storage;
+  cairo_surface_t *surface;
+} tileDecodeJob;
+
+/**
+ * @brief Where tiles are read from.
+ */
+typedef enum tileSourceType {
+  TILE_SOURCE_NONE,
+  TILE_SOURCE_DIR,
+  TILE_SOURCE_MBTILES
+} tileSourceType;
+
+static tileSourceType sourceType = TILE_SOURCE_NONE;
+static char *sourcePath = NULL;
+static int minZoom = 0;
+static int maxZoom = 0;
+static bool haveCenter = false;
+static double centerLat = 0;
+static double centerLon = 0;
+
+static GHashTable *tileIndex = NULL;
+static GQueue lru = G_QUEUE_INIT;
+static size_t cacheBytes = 0;
+static size_t cacheBudget = 0;
+static size_t peakBytes = 0;
+static tileStorage storage = TILE_STORAGE_ARGB32;
+static unsigned int currentFrame = 0;
+static unsigned int pendingTiles = 0;
+static tileCacheStats stats;
+
+// Bumped on every open and close, so decodes queued for an older source are skipped and dropped
+static unsigned int sourceGeneration = 0;
+// Read-held by workers while they read the source, so closing it waits for them
+static pthread_rwlock_t sourceLock = PTHREAD_RWLOCK_INITIALIZER;
+static tileReadyFunc readyFunc = NULL;
+static void *readyData = NULL;
+
+#ifdef USE_MBTILES
+static sqlite3 *mbtiles = NULL;
+#define MBTILES_TILE_QUERY "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?"
+#endif
+
+static inline gint64 tileKey(int z, int x, int y) {
+  return ((gint64)z << 58) | ((gint64)x << 29) | (gint64)y;
+}
+
+//////////////// PROJECTION //////////////////
+
+void tileEngineProject(double lat, double lon, int zoom, double *x, double *y) {
+  double worldSize = (double)TILE_SIZE * (double)(1u << zoom);
+  double latRad = CLAMP(lat, -85.05112878, 85.05112878) * M_PI / 180.0;
+  *x = (lon + 180.0) / 360.0 * worldSize;
+  *y = (1.0 - log(tan(latRad) + 1.0 / cos(latRad)) / M_PI) / 2.0 * worldSize;
+}
+
+/**
+ * @brief Inverse of tileEngineProject, used for the coverage centre.
+ */
+static void tileUnproject(double x, double y, int zoom, double *lat, double *lon) {
+  double worldSize = (double)TILE_SIZE * (double)(1u << zoom);
+  *lon = x / worldSize * 360.0 - 180.0;
+  *lat = atan(sinh(M_PI * (1.0 - 2.0 * y / worldSize))) * 180.0 / M_PI;
+}
+
+//////////////// SOURCES //////////////////
+
+/**
+ * @brief Parses a directory entry name as a non-negative integer.
+ *
+ * @return int Value, or -1 if the name is not purely numeric
+ */
+static int numericName(const char *name) {
+  if (!*name) return -1;
+  long value = 0;
+  for (const char *p = name; *p; p++) {
+    if (*p < '0' || *p > '9' || value > (1L << 30)) return -1;
+    value = value * 10 + (*p - '0');
+  }
+  return (int)value;
+}
+
+/**
+ * @brief Finds the numeric range of the entries in a directory.
+ *
+ * Entries like "123.png" count as 123 when stripSuffix is set.
+ *
+ * @return bool False if the directory has no numeric entries
+ */
+static bool numericRange(const char *dir, bool stripSuffix, int *lo, int *hi) {
+  GDir *d = g_dir_open(dir, 0, NULL);
+  if (!d) return false;
+  bool found = false;
+  const gchar *name;
+  while ((name = g_dir_read_name(d)) != NULL) {
+    char base[32];
+    snprintf(base, sizeof(base), "%s", name);
+    if (stripSuffix) {
+      char *dot = strchr(base, '.');
+      if (dot) *dot = '\0';
+    }
+    int value = numericName(base);
+    if (value < 0) continue;
+    if (!found || value < *lo) *lo = value;
+    if (!found || value > *hi) *hi = value;
+    found = true;
+  }
+  g_dir_close(d);
+  return found;
+}
+
+/**
+ * @brief Reads one value from a tile directory's metadata file (written by tile_build).
+ *
+ * @return bool True if the file exists and has the key
+ */
+static bool directoryMetadata(const char *path, const char *name, char *out, size_t outLen) {
+  char metaPath[512];
+  snprintf(metaPath, sizeof(metaPath), "%s/%s", path, TILE_METADATA_FILE);
+  FILE *file = fopen(metaPath, "r");
+  if (!file) return false;
+  bool found = false;
+  size_t nameLen = strlen(name);
+  char line[256];
+  while (!found && fgets(line, sizeof(line), file)) {
+    if (strncmp(line, name, nameLen) != 0 || line[nameLen] != '=') continue;
+    snprintf(out, outLen, "%s", line + nameLen + 1);
+    out[strcspn(out, "\r\n")] = '\0';
+    found = true;
+  }
+  fclose(file);
+  return found;
+}
+
+/**
+ * @brief Reads a z/x/y directory's zoom range and centre from its metadata,
+ *        or scans its directories for them.
+ */
+static int openDirectory(const char *path) {
+  char value[128];
+  double lon, lat;
+  if (directoryMetadata(path, "center", value, sizeof(value)) && sscanf(value, "%lf,%lf", &lon, &lat) == 2) {
+    centerLat = lat;
+    centerLon = lon;
+    haveCenter = true;
+  }
+  if (directoryMetadata(path, "minzoom", value, sizeof(value))) {
+    minZoom = atoi(value);
+    maxZoom = directoryMetadata(path, "maxzoom", value, sizeof(value)) ? atoi(value) : TILE_MAX_ZOOM;
+  } else if (!numericRange(path, false, &minZoom, &maxZoom)) {
+    printf("Error: %s has no zoom level directories\n", path);
+    return -1;
+  }
+  if (maxZoom > TILE_MAX_ZOOM) maxZoom = TILE_MAX_ZOOM;
+  if (haveCenter) {
+    sourceType = TILE_SOURCE_DIR;
+    return 0;
+  }
+
+  char zoomDir[512];
+  snprintf(zoomDir, sizeof(zoomDir), "%s/%d", path, maxZoom);
+  int xLo, xHi, yLo, yHi;
+  if (numericRange(zoomDir, false, &xLo, &xHi)) {
+    char columnDir[600];
+    snprintf(columnDir, sizeof(columnDir), "%s/%d", zoomDir, (xLo + xHi) / 2);
+    if (numericRange(columnDir, true, &yLo, &yHi)) {
+      tileUnproject((xLo + xHi + 1) * TILE_SIZE / 2.0, (yLo + yHi + 1) * TILE_SIZE / 2.0,
+                    maxZoom, &centerLat, &centerLon);
+      haveCenter = true;
+    }
+  }
+  sourceType = TILE_SOURCE_DIR;
+  return 0;
+}
+
+#ifdef USE_MBTILES
+/**
+ * @brief Reads one value from the MBTiles metadata table.
+ *
+ * @return bool True if the key exists
+ */
+static bool mbtilesMetadata(const char *name, char *out, size_t outLen) {
+  sqlite3_stmt *stmt;
+  if (sqlite3_prepare_v2(mbtiles, "SELECT value FROM metadata WHERE name = ?", -1, &stmt, NULL) != SQLITE_OK) {
+    return false;
+  }
+  sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+  bool found = false;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    snprintf(out, outLen, "%s", (const char *)sqlite3_column_text(stmt, 0));
+    found = true;
+  }
+  sqlite3_finalize(stmt);
+  return found;
+}
+
+/**
+ * @brief Opens an MBTiles file read-only and reads its zoom range and centre.
+ */
+static int openMBTiles(const char *path) {
+  // Workers query the connection concurrently, each with its own statement
+  if (sqlite3_open_v2(path, &mbtiles, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX, NULL) != SQLITE_OK) {
+    printf("Error: cannot open %s: %s\n", path, sqlite3_errmsg(mbtiles));
+    sqlite3_close(mbtiles);
+    mbtiles = NULL;
+    return -1;
+  }
+  sqlite3_stmt *tileQuery;
+  if (sqlite3_prepare_v2(mbtiles, MBTILES_TILE_QUERY, -1, &tileQuery, NULL) != SQLITE_OK) {
+    printf("Error: %s is not an MBTiles file: %s\n", path, sqlite3_errmsg(mbtiles));
+    sqlite3_close(mbtiles);
+    mbtiles = NULL;
+    return -1;
+  }
+  sqlite3_finalize(tileQuery);
+
+  char value[128];
+  minZoom = 0;
+  maxZoom = TILE_MAX_ZOOM;
+  if (mbtilesMetadata("minzoom", value, sizeof(value))) minZoom = atoi(value);
+  if (mbtilesMetadata("maxzoom", value, sizeof(value))) maxZoom = atoi(value);
+  if (maxZoom > TILE_MAX_ZOOM) maxZoom = TILE_MAX_ZOOM;
+
+  double lon, lat, west, south, east, north;
+  if (mbtilesMetadata("center", value, sizeof(value)) && sscanf(value, "%lf,%lf", &lon, &lat) == 2) {
+    centerLat = lat;
+    centerLon = lon;
+    haveCenter = true;
+  } else if (mbtilesMetadata("bounds", value, sizeof(value)) &&
+             sscanf(value, "%lf,%lf,%lf,%lf", &west, &south, &east, &north) == 4) {
+    centerLat = (south + north) / 2;
+    centerLon = (west + east) / 2;
+    haveCenter = true;
+  }
+  sourceType = TILE_SOURCE_MBTILES;
+  return 0;
+}
+
+/**
+ * @brief Decodes an MBTiles blob (PNG or JPEG) into a surface. Runs on a worker.
+ */
+static cairo_surface_t *loadMBTile(int z, int x, int y) {
+  sqlite3_stmt *tileQuery;
+  if (sqlite3_prepare_v2(mbtiles, MBTILES_TILE_QUERY, -1, &tileQuery, NULL) != SQLITE_OK) return NULL;
+  int tmsRow = (1 << z) - 1 - y;
+  sqlite3_bind_int(tileQuery, 1, z);
+  sqlite3_bind_int(tileQuery, 2, x);
+  sqlite3_bind_int(tileQuery, 3, tmsRow);
+
+  cairo_surface_t *surface = NULL;
+  if (sqlite3_step(tileQuery) == SQLITE_ROW) {
+    const guchar *blob = sqlite3_column_blob(tileQuery, 0);
+    int len = sqlite3_column_bytes(tileQuery, 0);
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+    if (gdk_pixbuf_loader_write(loader, blob, len, NULL) && gdk_pixbuf_loader_close(loader, NULL)) {
+      GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+      if (pixbuf) surface = mapSurfaceFromPixbuf(pixbuf);
+    } else {
+      gdk_pixbuf_loader_close(loader, NULL);
+    }
+    g_object_unref(loader);
+  }
+  sqlite3_finalize(tileQuery);
+  return surface;
+}
+#endif
+
+/**
+ * @brief Reads and decodes a tile from the open source. Runs on a worker.
+ *
+ * @return cairo_surface_t* Decoded tile, or NULL if the pack does not have it
+ */
+static cairo_surface_t *loadTile(int z, int x, int y) {
+#ifdef USE_MBTILES
+  if (sourceType == TILE_SOURCE_MBTILES) return loadMBTile(z, x, y);
+#endif
+  char path[600];
+  snprintf(path, sizeof(path), "%s/%d/%d/%d.png", sourcePath, z, x, y);
+  GdkPixbuf *pixbuf = mapPixbufLoad(path);
+  if (!pixbuf) return NULL;
+  cairo_surface_t *surface = mapSurfaceFromPixbuf(pixbuf);
+  g_object_unref(pixbuf);
+  return surface;
+}
+
+//////////////// LRU CACHE //////////////////
+
+static void freeEntry(tileEntry *entry) {
+  if (entry->surface) cairo_surface_destroy(entry->surface);
+  free(entry);
+}
+
+/**
+ * @brief Evicts least recently used tiles until the cache fits its budget.
+ *
+ * Tiles used in the current frame are kept even if that leaves the cache over budget.
+ */
+static void evictToBudget() {
+  while (cacheBytes > cacheBudget && lru.tail) {
+    tileEntry *entry = (tileEntry *)lru.tail->data;
+    if (entry->frame == currentFrame) break;
+    g_queue_unlink(&lru, &entry->link);
+    g_hash_table_remove(tileIndex, &entry->key);
+    cacheBytes -= entry->bytes;
+    stats.evictions++;
+    freeEntry(entry);
+  }
+}
+
+/**
+ * @brief Worker job: reads and decodes one tile, then converts it to the storage format.
+ */
+static void decodeTileJob(void *data) {
+  tileDecodeJob *job = (tileDecodeJob *)data;
+  pthread_rwlock_rdlock(&sourceLock);
+  if (job->generation == sourceGeneration) job->surface = loadTile(job->z, job->x, job->y);
+  pthread_rwlock_unlock(&sourceLock);
+  if (!job->surface || job->storage != TILE_STORAGE_RGB565) return;
+  // Transparent parts end up the grey that missing tiles are drawn in
+  cairo_surface_t *packed = mapSurfaceConvert(job->surface, CAIRO_FORMAT_RGB16_565, 0.85, 0.85, 0.85);
+  if (!packed) return;
+  cairo_surface_destroy(job->surface);
+  job->surface = packed;
+}
+
+/**
+ * @brief Completion on the GTK thread: moves the decoded tile into the LRU.
+ */
+static void decodeTileDone(void *data) {
+  tileDecodeJob *job = (tileDecodeJob *)data;
+  gint64 key = tileKey(job->z, job->x, job->y);
+  tileEntry *entry = NULL;
+  if (tileIndex && job->generation == sourceGeneration) {
+    entry = (tileEntry *)g_hash_table_lookup(tileIndex, &key);
+  }
+  if (!entry || !entry->pending) {
+    // The source was closed or reopened while the job ran
+    if (job->surface) cairo_surface_destroy(job->surface);
+    free(job);
+    return;
+  }
+
+  pendingTiles--;
+  entry->pending = false;
+  entry->surface = job->surface;
+  entry->bytes = sizeof(tileEntry);
+  if (entry->surface) {
+    entry->bytes += (size_t)cairo_image_surface_get_stride(entry->surface) *
+                    cairo_image_surface_get_height(entry->surface);
+  } else {
+    stats.missing++;
+  }
+  g_queue_push_head_link(&lru, &entry->link);
+  cacheBytes += entry->bytes;
+  evictToBudget();
+  if (cacheBytes > peakBytes) peakBytes = cacheBytes;
+  free(job);
+  if (readyFunc) readyFunc(readyData);
+}
+
+/**
+ * @brief Looks up a tile, queueing a background decode on a miss.
+ *
+ * @return tileEntry* Cache entry; pending until its decode lands
+ */
+static tileEntry *fetchTile(int z, int x, int y) {
+  gint64 key = tileKey(z, x, y);
+  tileEntry *entry = (tileEntry *)g_hash_table_lookup(tileIndex, &key);
+  if (entry) {
+    if (entry->pending) return entry;
+    stats.hits++;
+    g_queue_unlink(&lru, &entry->link);
+    g_queue_push_head_link(&lru, &entry->link);
+    entry->frame = currentFrame;
+    return entry;
+  }
+
+  stats.misses++;
+  entry = (tileEntry *)calloc(1, sizeof(tileEntry));
+  entry->key = key;
+  entry->frame = currentFrame;
+  entry->pending = true;
+  entry->link.data = entry;
+  g_hash_table_insert(tileIndex, &entry->key, entry);
+  pendingTiles++;
+
+  tileDecodeJob *job = (tileDecodeJob *)calloc(1, sizeof(tileDecodeJob));
+  job->z = z;
+  job->x = x;
+  job->y = y;
+  job->generation = sourceGeneration;
+  job->storage = storage;
+  workerPoolSubmit(decodeTileJob, decodeTileDone, job);
+  return entry;
+}
+
+/**
+ * @brief Finds the nearest cached ancestor of a tile to stand in while it decodes.
+ *
+ * @param levels Set to how many zoom levels above the tile the ancestor is
+ * @return cairo_surface_t* Ancestor surface, or NULL if none is cached
+ */
+static cairo_surface_t *ancestorTile(int z, int x, int y, int *levels) {
+  for (int d = 1; d <= TILE_PLACEHOLDER_LEVELS && z - d >= minZoom; d++) {
+    gint64 key = tileKey(z - d, x >> d, y >> d);
+    tileEntry *entry = (tileEntry *)g_hash_table_lookup(tileIndex, &key);
+    if (entry && entry->surface) {
+      entry->frame = currentFrame;
+      *levels = d;
+      return entry->surface;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Paints the stand-in for a tile that is still decoding: the matching
+ *        part of a cached ancestor scaled up, or a flat fill.
+ */
+static void paintPlaceholder(cairo_t *cr, int z, int x, int y, double screenX, double screenY) {
+  stats.placeholders++;
+  int levels;
+  cairo_surface_t *ancestor = ancestorTile(z, x, y, &levels);
+  if (!ancestor) {
+    cairo_set_source_rgb(cr, 0.9, 0.9, 0.9);
+    cairo_rectangle(cr, screenX, screenY, TILE_SIZE, TILE_SIZE);
+    cairo_fill(cr);
+    return;
+  }
+
+  int scale = 1 << levels;
+  int part = TILE_SIZE / scale;
+  cairo_save(cr);
+  cairo_rectangle(cr, screenX, screenY, TILE_SIZE, TILE_SIZE);
+  cairo_clip(cr);
+  cairo_translate(cr, screenX, screenY);
+  cairo_scale(cr, scale, scale);
+  cairo_set_source_surface(cr, ancestor, -(x & (scale - 1)) * part, -(y & (scale - 1)) * part);
+  cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_BILINEAR);
+  cairo_paint(cr);
+  cairo_restore(cr);
+}
+
+//////////////// ENGINE //////////////////
+
+const char *tileStorageName(tileStorage mode) {
+  return mode == TILE_STORAGE_RGB565 ? "rgb565" : "argb32";
+}
+
+int tileEngineOpen(const char *source, size_t budget, tileStorage mode) {
+  if (tileEngineActive()) tileEngineClose();
+  haveCenter = false;
+
+  int status;
+  if (g_str_has_suffix(source, ".mbtiles")) {
+#ifdef USE_MBTILES
+    status = openMBTiles(source);
+#else
+    printf("Error: %s needs MBTiles support (rebuild with MBTILES=1)\n", source);
+    status = -1;
+#endif
+  } else {
+    status = openDirectory(source);
+  }
+  if (status != 0) return -1;
+
+  sourcePath = g_strdup(source);
+  sourceGeneration++;
+  pendingTiles = 0;
+  tileIndex = g_hash_table_new(g_int64_hash, g_int64_equal);
+  g_queue_init(&lru);
+  cacheBytes = 0;
+  peakBytes = 0;
+  cacheBudget = budget > 0 ? budget : (size_t)TILE_CACHE_DEFAULT_MB << 20;
+  storage = mode;
+  memset(&stats, 0, sizeof(stats));
+  printf("Tiles: %s, zoom %d-%d, cache budget %zu MB, %s\n", source, minZoom, maxZoom, cacheBudget >> 20,
+         tileStorageName(storage));
+  return 0;
+}
+
+void tileEngineClose() {
+  if (!tileEngineActive()) return;
+  tileCacheStats final;
+  tileEngineGetStats(&final);
+  printf("Tile cache (%s): %lu hits, %lu misses, %lu evictions, %lu placeholders, %u tiles / %zu KB held, "
+         "peak %zu KB\n", tileStorageName(final.storage), final.hits, final.misses, final.evictions,
+         final.placeholders, final.tiles, final.bytes >> 10, final.peakBytes >> 10);
+
+  // Pending entries are only in the index, so free through it rather than the LRU
+  GHashTableIter iter;
+  gpointer value;
+  g_hash_table_iter_init(&iter, tileIndex);
+  while (g_hash_table_iter_next(&iter, NULL, &value)) {
+    freeEntry((tileEntry *)value);
+  }
+  g_hash_table_destroy(tileIndex);
+  tileIndex = NULL;
+  g_queue_init(&lru);
+  cacheBytes = 0;
+  pendingTiles = 0;
+
+  // Waits out decodes reading the source now; the rest see the new generation and skip it
+  pthread_rwlock_wrlock(&sourceLock);
+  sourceGeneration++;
+#ifdef USE_MBTILES
+  if (mbtiles) sqlite3_close(mbtiles);
+  mbtiles = NULL;
+#endif
+  g_free(sourcePath);
+  sourcePath = NULL;
+  sourceType = TILE_SOURCE_NONE;
+  pthread_rwlock_unlock(&sourceLock);
+}
+
+void tileEngineSetReadyFunc(tileReadyFunc onReady, void *data) {
+  readyFunc = onReady;
+  readyData = data;
+}
+
+bool tileEngineActive() {
+  return sourceType != TILE_SOURCE_NONE;
+}
+
+int tileEngineMinZoom() {
+  return minZoom;
+}
+
+int tileEngineMaxZoom() {
+  return maxZoom;
+}
+
+bool tileEngineDefaultCenter(double *lat, double *lon) {
+  if (!haveCenter) return false;
+  *lat = centerLat;
+  *lon = centerLon;
+  return true;
+}
+
+void tileEngineDraw(cairo_t *cr, int width, int height, double centerX, double centerY, int zoom) {
+  if (!tileEngineActive()) return;
+  zoom = CLAMP(zoom, minZoom, maxZoom);
+  currentFrame++;
+
+  // Only tiles under both the viewport and the clip are needed
+  double clipX1, clipY1, clipX2, clipY2;
+  cairo_clip_extents(cr, &clipX1, &clipY1, &clipX2, &clipY2);
+  clipX1 = MAX(clipX1, 0);
+  clipY1 = MAX(clipY1, 0);
+  clipX2 = MIN(clipX2, width);
+  clipY2 = MIN(clipY2, height);
+  if (clipX2 <= clipX1 || clipY2 <= clipY1) return;
+
+  double originX = floor(centerX - width / 2.0);
+  double originY = floor(centerY - height / 2.0);
+  int tilesPerSide = 1 << zoom;
+  int firstX = (int)floor((originX + clipX1) / TILE_SIZE);
+  int lastX = (int)floor((originX + clipX2 - 1) / TILE_SIZE);
+  int firstY = (int)floor((originY + clipY1) / TILE_SIZE);
+  int lastY = (int)floor((originY + clipY2 - 1) / TILE_SIZE);
+
+  cairo_save(cr);
+  cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+  for (int ty = firstY; ty <= lastY; ty++) {
+    for (int tx = firstX; tx <= lastX; tx++) {
+      double screenX = tx * (double)TILE_SIZE - originX;
+      double screenY = ty * (double)TILE_SIZE - originY;
+      cairo_surface_t *tile = NULL;
+      if (ty >= 0 && ty < tilesPerSide) {
+        // Longitude wraps around the antimeridian
+        int wrappedX = ((tx % tilesPerSide) + tilesPerSide) % tilesPerSide;
+        tileEntry *entry = fetchTile(zoom, wrappedX, ty);
+        if (entry->pending) {
+          paintPlaceholder(cr, zoom, wrappedX, ty, screenX, screenY);
+          continue;
+        }
+        tile = entry->surface;
+      }
+      if (tile) {
+        cairo_set_source_surface(cr, tile, screenX, screenY);
+        cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+      } else {
+        cairo_set_source_rgb(cr, 0.85, 0.85, 0.85);
+      }
+      cairo_rectangle(cr, screenX, screenY, TILE_SIZE, TILE_SIZE);
+      cairo_fill(cr);
+    }
+  }
+  cairo_restore(cr);
+}
+
+void tileEngineGetStats(tileCacheStats *out) {
+  *out = stats;
+  out->bytes = cacheBytes;
+  out->peakBytes = peakBytes;
+  out->budget = cacheBudget;
+  out->storage = storage;
+  out->tiles = lru.length;
+  out->pending = pendingTiles;
+}
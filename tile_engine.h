@@ -0,0 +1,177 @@
+/**
+ * @file        tile_engine.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       z/x/y map tile engine with a memory-bounded LRU cache of decoded tiles.
+ *
+ * @details     Reads 256x256 Web Mercator tiles from either
+ *              - a directory laid out as `<root>/<z>/<x>/<y>.png` (XYZ scheme), with an
+ *                optional TILE_METADATA_FILE giving its centre and zoom range, or
+ *              - an MBTiles file (TMS rows), when built with `MBTILES=1`,
+ *
+ *              and draws only the tiles covering the visible viewport. Decoded tiles are
+ *              kept as cairo image surfaces in an LRU cache bounded by a byte budget, so a
+ *              map pack covering a whole state costs no more RAM than a single screen's
+ *              worth of neighbourhood. Tiles missing from the pack are cached as cheap
+ *              negative entries so the disk is not searched again on every draw.
+ *
+ *              Tiles are read and decoded on the worker pool. The draw shows a placeholder
+ *              until they arrive, and the ready callback asks for a repaint.
+ *
+ *              Tiles can be stored as RGB16_565 instead of ARGB32 (TILE_STORAGE_RGB565),
+ *              which halves the memory each tile takes, so the same budget holds twice the
+ *              tiles on low-RAM boards. Tiles are converted once after decoding and are
+ *              expanded again by pixman's SIMD blitters when drawn.
+ *
+ *              The engine is a singleton used from the GTK thread only.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef TILE_ENGINE_H
+#define TILE_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <cairo.h>
+
+// Edge length of a map tile in pixels
+#define TILE_SIZE 256
+// Default decoded-tile cache budget (~128 ARGB32 tiles)
+#define TILE_CACHE_DEFAULT_MB 32
+// Deepest zoom level the engine will address
+#define TILE_MAX_ZOOM 22
+// Optional key=value file in a tile directory's root with its bounds, centre and zoom range
+#define TILE_METADATA_FILE "metadata.txt"
+// How many zoom levels up to look for a cached tile to stand in for a decoding one
+#define TILE_PLACEHOLDER_LEVELS 3
+
+/**
+ * @brief Pixel format decoded tiles are kept in.
+ */
+typedef enum tileStorage {
+  TILE_STORAGE_ARGB32,      // 4 bytes per pixel, keeps tile transparency
+  TILE_STORAGE_RGB565       // 2 bytes per pixel, flattened onto the missing-tile grey
+} tileStorage;
+
+/**
+ * @brief Decoded-tile cache counters.
+ */
+typedef struct tileCacheStats {
+  unsigned long hits;
+  unsigned long misses;      // tile had to be read and decoded
+  unsigned long evictions;
+  unsigned long missing;     // tiles absent from the pack (negative entries created)
+  unsigned long placeholders; // tiles drawn as a stand-in while decoding
+  size_t bytes;              // memory held by cached surfaces
+  size_t peakBytes;          // most memory held at once
+  size_t budget;
+  tileStorage storage;
+  unsigned int tiles;        // entries in the cache
+  unsigned int pending;      // decodes in flight
+} tileCacheStats;
+
+/**
+ * @brief Called on the GTK thread whenever a decoded tile has been cached.
+ */
+typedef void (*tileReadyFunc)(void *data);
+
+/**
+ * @brief Opens a tile directory or .mbtiles file.
+ *
+ * @param source Directory root or path ending in ".mbtiles"
+ * @param cacheBytes Budget for decoded tiles; 0 selects TILE_CACHE_DEFAULT_MB
+ * @param storage Pixel format the decoded tiles are kept in
+ * @return int 0 on success, -1 if the source cannot be used
+ */
+int tileEngineOpen(const char *source, size_t cacheBytes, tileStorage storage);
+
+/**
+ * @brief Name of a storage mode, as given to --tile-format.
+ */
+const char *tileStorageName(tileStorage storage);
+
+/**
+ * @brief Frees every cached tile and closes the source.
+ *
+ * Waits for decodes that are reading the source; decodes still queued skip
+ * the read and are dropped when they complete. Safe with the worker pool
+ * running, and called before it is stopped so its drained jobs find the
+ * engine closed.
+ */
+void tileEngineClose();
+
+/**
+ * @brief Sets the callback run after each background tile decode lands.
+ *
+ * @param onReady Usually queues a redraw, may be NULL
+ * @param data Passed to onReady
+ */
+void tileEngineSetReadyFunc(tileReadyFunc onReady, void *data);
+
+/**
+ * @brief True once a tile source has been opened.
+ */
+bool tileEngineActive();
+
+/**
+ * @brief Zoom range available in the source.
+ */
+int tileEngineMinZoom();
+int tileEngineMaxZoom();
+
+/**
+ * @brief Suggested view centre when there is no fix yet (centre of the pack's coverage).
+ *
+ * @return bool False if the source gives no hint
+ */
+bool tileEngineDefaultCenter(double *lat, double *lon);
+
+/**
+ * @brief Projects latitude/longitude to global Web Mercator pixels at a zoom level.
+ */
+void tileEngineProject(double lat, double lon, int zoom, double *x, double *y);
+
+/**
+ * @brief Draws the tiles covering a viewport centred on a global pixel position.
+ *
+ * Only tiles that intersect both the viewport and the current cairo clip are
+ * fetched and painted; tiles absent from the pack are drawn as a flat fill.
+ * Never blocks on decoding: uncached tiles are queued on the worker pool and
+ * drawn as placeholders for now.
+ *
+ * @param cr Cairo context in viewport coordinates
+ * @param width Viewport width in pixels
+ * @param height Viewport height in pixels
+ * @param centerX Global pixel X at the viewport centre
+ * @param centerY Global pixel Y at the viewport centre
+ * @param zoom Zoom level
+ */
+void tileEngineDraw(cairo_t *cr, int width, int height, double centerX, double centerY, int zoom);
+
+/**
+ * @brief Copies the cache counters.
+ */
+void tileEngineGetStats(tileCacheStats *stats);
+
+#endif
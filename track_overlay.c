@@ -0,0 +1,334 @@
+/**
+ * @file        track_overlay.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Breadcrumb track of recent fixes, drawn over the map.
+ *
+ * @details     Simplification works in degrees with longitude scaled by the cosine of the
+ *              track's starting latitude, so the tolerance is roughly isotropic on the ground.
+ *              Consecutive chunks share their end points, so the per-level polylines stay
+ *              continuous without ever re-simplifying sealed history.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "track_overlay.h"
+#include "tile_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief One simplification level: sealed history reduced to the level's tolerance.
+ */
+typedef struct trackLevel {
+  mapCoord *points;
+  size_t count;
+  size_t capacity;
+} trackLevel;
+
+static mapCoord *rawPoints = NULL;
+static size_t rawCount = 0;
+static size_t sealedCount = 0;     // raw points folded into every level (last one shared with the tail)
+static double lonScale = 1.0;      // cos(latitude) at the start of the track
+static trackLevel levels[TRACK_LEVELS];
+
+// Cached overlay for the single-image map
+static cairo_surface_t *imageOverlay = NULL;
+static mapProjection imageProj;
+static size_t imageDrawnCount = 0; // raw points already stroked onto the overlay
+static bool imageDropped = false;  // overlay thrown away with the oldest fixes, not yet reported
+
+//////////////// SIMPLIFICATION //////////////////
+
+static void levelPush(trackLevel *level, mapCoord point) {
+  if (level->count == level->capacity) {
+    level->capacity = level->capacity ? level->capacity * 2 : TRACK_CHUNK;
+    level->points = (mapCoord *)realloc(level->points, level->capacity * sizeof(mapCoord));
+  }
+  level->points[level->count++] = point;
+}
+
+/**
+ * @brief Squared distance (in scaled 1e-7 degrees) of p from the segment a-b.
+ */
+static double segmentDistance2(mapCoord p, mapCoord a, mapCoord b) {
+  double px = (p.lonE7 - a.lonE7) * lonScale, py = p.latE7 - a.latE7;
+  double bx = (b.lonE7 - a.lonE7) * lonScale, by = b.latE7 - a.latE7;
+  double len2 = bx * bx + by * by;
+  double t = len2 > 0 ? (px * bx + py * by) / len2 : 0;
+  if (t < 0) t = 0;
+  if (t > 1) t = 1;
+  double dx = px - t * bx, dy = py - t * by;
+  return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Douglas-Peucker over points[first..last], marking the points to keep.
+ */
+static void simplify(const mapCoord *points, int first, int last, double tolerance2, bool *keep) {
+  if (last - first < 2) return;
+  double worst = -1;
+  int worstIndex = first;
+  for (int i = first + 1; i < last; i++) {
+    double d = segmentDistance2(points[i], points[first], points[last]);
+    if (d > worst) {
+      worst = d;
+      worstIndex = i;
+    }
+  }
+  if (worst <= tolerance2) return;
+  keep[worstIndex] = true;
+  simplify(points, first, worstIndex, tolerance2, keep);
+  simplify(points, worstIndex, last, tolerance2, keep);
+}
+
+/**
+ * @brief Folds every complete chunk after sealedCount into all levels.
+ */
+static void sealChunks() {
+  while (rawCount >= sealedCount + TRACK_CHUNK + 1) {
+    const mapCoord *chunk = rawPoints + sealedCount;
+    for (int k = 0; k < TRACK_LEVELS; k++) {
+      bool keep[TRACK_CHUNK + 1] = {false};
+      double tolerance = (double)(TRACK_BASE_TOLERANCE_E7 << k);
+      simplify(chunk, 0, TRACK_CHUNK, tolerance * tolerance, keep);
+      // The chunk's first point is already the level's last one
+      for (int i = 1; i < TRACK_CHUNK; i++) {
+        if (keep[i]) levelPush(&levels[k], chunk[i]);
+      }
+      levelPush(&levels[k], chunk[TRACK_CHUNK]);
+    }
+    sealedCount += TRACK_CHUNK;
+  }
+}
+
+static void resetLevels() {
+  for (int k = 0; k < TRACK_LEVELS; k++) {
+    levels[k].count = 0;
+    if (rawCount > 0) levelPush(&levels[k], rawPoints[0]);
+  }
+  sealedCount = 0;
+}
+
+static void invalidateImageOverlay() {
+  if (imageOverlay) cairo_surface_destroy(imageOverlay);
+  imageOverlay = NULL;
+  imageDrawnCount = 0;
+}
+
+bool trackAppend(mapCoord fix) {
+  if (!rawPoints) {
+    rawPoints = (mapCoord *)malloc(TRACK_MAX_POINTS * sizeof(mapCoord));
+  }
+  if (rawCount > 0) {
+    mapCoord last = rawPoints[rawCount - 1];
+    double dx = (fix.lonE7 - last.lonE7) * lonScale, dy = fix.latE7 - last.latE7;
+    if (dx * dx + dy * dy < (double)TRACK_BASE_TOLERANCE_E7 * TRACK_BASE_TOLERANCE_E7) return false;
+  } else {
+    lonScale = cos(fix.latE7 / 1e7 * M_PI / 180.0);
+  }
+
+  if (rawCount == TRACK_MAX_POINTS) {
+    // Drop the oldest quarter and rebuild the levels from what is left
+    size_t drop = TRACK_MAX_POINTS / 4;
+    memmove(rawPoints, rawPoints + drop, (rawCount - drop) * sizeof(mapCoord));
+    rawCount -= drop;
+    resetLevels();
+    sealChunks();
+    invalidateImageOverlay();
+    imageDropped = true;
+  }
+
+  rawPoints[rawCount++] = fix;
+  if (rawCount == 1) resetLevels();
+  sealChunks();
+  return true;
+}
+
+size_t trackLength() {
+  return rawCount;
+}
+
+bool trackImageInvalidated() {
+  bool dropped = imageDropped;
+  imageDropped = false;
+  return dropped;
+}
+
+//////////////// DRAWING //////////////////
+
+/**
+ * @brief Picks the coarsest level whose tolerance stays under one pixel.
+ *
+ * @param e7PerPixel Size of one pixel in 1e-7 degrees
+ */
+static const trackLevel *levelForScale(double e7PerPixel) {
+  int k = 0;
+  while (k + 1 < TRACK_LEVELS && (double)(TRACK_BASE_TOLERANCE_E7 << (k + 1)) <= e7PerPixel) k++;
+  return &levels[k];
+}
+
+/**
+ * @brief Calls visit for the level's polyline followed by the unsealed raw tail.
+ */
+static void forEachPoint(const trackLevel *level, void (*visit)(mapCoord, void *), void *data) {
+  for (size_t i = 0; i < level->count; i++) visit(level->points[i], data);
+  for (size_t i = sealedCount + 1; i < rawCount; i++) visit(rawPoints[i], data);
+}
+
+static void strokeStyle(cairo_t *cr) {
+  cairo_set_line_width(cr, TRACK_LINE_WIDTH);
+  cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+  cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+}
+
+static void imagePathPoint(mapCoord coord, void *data) {
+  cairo_t *cr = (cairo_t *)data;
+  mapPoint point = mapProject(&imageProj, coord);
+  cairo_line_to(cr, point.x / (double)MAP_FIXED_ONE, point.y / (double)MAP_FIXED_ONE);
+}
+
+static bool sameProjection(const mapProjection *a, const mapProjection *b) {
+  return a->type == b->type && a->width == b->width && a->height == b->height &&
+         a->originX == b->originX && a->originY == b->originY && a->xx == b->xx && a->yy == b->yy;
+}
+
+/**
+ * @brief Builds the image overlay from the simplified track.
+ */
+static void buildImageOverlay(const mapProjection *proj) {
+  invalidateImageOverlay();
+  imageProj = *proj;
+  imageOverlay = cairo_image_surface_create(CAIRO_FORMAT_A8, proj->width, proj->height);
+  if (cairo_surface_status(imageOverlay) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(imageOverlay);
+    imageOverlay = NULL;
+    return;
+  }
+  imageDrawnCount = rawCount;
+  if (rawCount < 2) return;
+
+  double e7PerPixel = fmin((proj->east - proj->west) * 1e7 / proj->width * lonScale,
+                           (proj->north - proj->south) * 1e7 / proj->height);
+  cairo_t *cr = cairo_create(imageOverlay);
+  strokeStyle(cr);
+  cairo_new_path(cr);
+  forEachPoint(levelForScale(e7PerPixel), imagePathPoint, cr);
+  cairo_stroke(cr);
+  cairo_destroy(cr);
+  cairo_surface_flush(imageOverlay);
+}
+
+bool trackUpdateImage(const mapProjection *proj, cairo_rectangle_int_t *damage) {
+  if (!imageOverlay || !sameProjection(proj, &imageProj) || rawCount <= imageDrawnCount) return false;
+  size_t first = imageDrawnCount > 0 ? imageDrawnCount - 1 : 0;
+  if (rawCount - first < 2) {
+    imageDrawnCount = rawCount;
+    return false;
+  }
+
+  cairo_t *cr = cairo_create(imageOverlay);
+  strokeStyle(cr);
+  int32_t minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+  for (size_t i = first; i < rawCount; i++) {
+    mapPoint point = mapProject(&imageProj, rawPoints[i]);
+    cairo_line_to(cr, point.x / (double)MAP_FIXED_ONE, point.y / (double)MAP_FIXED_ONE);
+    if (point.x < minX) minX = point.x;
+    if (point.y < minY) minY = point.y;
+    if (point.x > maxX) maxX = point.x;
+    if (point.y > maxY) maxY = point.y;
+  }
+  cairo_stroke(cr);
+  cairo_destroy(cr);
+  cairo_surface_flush(imageOverlay);
+  imageDrawnCount = rawCount;
+
+  int pad = (int)ceil(TRACK_LINE_WIDTH / 2) + 1;
+  damage->x = MAP_FIXED_TO_INT(minX) - pad;
+  damage->y = MAP_FIXED_TO_INT(minY) - pad;
+  damage->width = MAP_FIXED_TO_INT(maxX) - MAP_FIXED_TO_INT(minX) + 2 * pad + 1;
+  damage->height = MAP_FIXED_TO_INT(maxY) - MAP_FIXED_TO_INT(minY) + 2 * pad + 1;
+  return true;
+}
+
+void trackPaintImage(cairo_t *cr, const mapProjection *proj) {
+  if (rawCount < 2) return;
+  if (!imageOverlay || !sameProjection(proj, &imageProj)) buildImageOverlay(proj);
+  if (!imageOverlay) return;
+
+  cairo_save(cr);
+  cairo_rectangle(cr, 0, 0, proj->width, proj->height);
+  cairo_clip(cr);
+  cairo_set_source_rgba(cr, 0.1, 0.4, 0.9, 0.8);
+  cairo_mask_surface(cr, imageOverlay, 0, 0);
+  cairo_restore(cr);
+}
+
+/**
+ * @brief Tile view drawing state passed through forEachPoint.
+ */
+typedef struct tilePathState {
+  cairo_t *cr;
+  int zoom;
+  double originX;
+  double originY;
+} tilePathState;
+
+static void tilePathPoint(mapCoord coord, void *data) {
+  tilePathState *state = (tilePathState *)data;
+  double x, y;
+  tileEngineProject(coord.latE7 / 1e7, coord.lonE7 / 1e7, state->zoom, &x, &y);
+  cairo_line_to(state->cr, x - state->originX, y - state->originY);
+}
+
+void trackPaintTiles(cairo_t *cr, int zoom, double originX, double originY) {
+  if (rawCount < 2) return;
+  // Degrees of longitude per pixel, shrunk by cos(latitude) to match the ground scale
+  double e7PerPixel = 360e7 / ((double)TILE_SIZE * (1u << zoom)) * lonScale;
+  tilePathState state = {cr, zoom, originX, originY};
+
+  cairo_save(cr);
+  strokeStyle(cr);
+  cairo_set_source_rgba(cr, 0.1, 0.4, 0.9, 0.8);
+  cairo_new_path(cr);
+  forEachPoint(levelForScale(e7PerPixel), tilePathPoint, &state);
+  cairo_stroke(cr);
+  cairo_restore(cr);
+}
+
+void trackShutdown() {
+  invalidateImageOverlay();
+  for (int k = 0; k < TRACK_LEVELS; k++) {
+    free(levels[k].points);
+    levels[k].points = NULL;
+    levels[k].count = 0;
+    levels[k].capacity = 0;
+  }
+  free(rawPoints);
+  rawPoints = NULL;
+  rawCount = 0;
+  sealedCount = 0;
+  imageDropped = false;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file        track_overlay.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Breadcrumb track of recent fixes, drawn over the map.
+ *
+ * @details     Fixes are logged in the receiver's 1e-7 degree units. The log is sealed in
+ *              chunks of TRACK_CHUNK points, and each sealed chunk is simplified with
+ *              Douglas-Peucker into TRACK_LEVELS polylines whose tolerance doubles at each
+ *              level. A renderer draws the coarsest level whose tolerance is still under a
+ *              pixel, plus the short unsealed tail, so hours of track stay a few hundred
+ *              segments at any zoom.
+ *
+ *              On the single-image map the track is kept on a cached A8 surface: new fixes
+ *              only stroke their new segment onto it, and the draw handler masks the clipped
+ *              part of the surface with the track colour. The tile view, which moves with
+ *              every fix, strokes the simplified polyline directly.
+ *
+ *              All functions run on the GTK thread.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef TRACK_OVERLAY_H
+#define TRACK_OVERLAY_H
+
+#include "map_projection.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <cairo.h>
+
+// Fixes kept (about 18 hours at 1 Hz); the oldest quarter is dropped when full
+#define TRACK_MAX_POINTS 65536
+// Points per simplification chunk
+#define TRACK_CHUNK 64
+// Simplification levels; level k tolerates TRACK_BASE_TOLERANCE_E7 << k
+#define TRACK_LEVELS 12
+// Finest simplification tolerance and minimum spacing of logged fixes (~1 m of latitude)
+#define TRACK_BASE_TOLERANCE_E7 90
+// Stroke width of the track in pixels
+#define TRACK_LINE_WIDTH 3.0
+
+/**
+ * @brief Adds a fix to the track.
+ *
+ * @return bool False if it is too close to the previous fix to be logged
+ */
+bool trackAppend(mapCoord fix);
+
+/**
+ * @brief Number of fixes currently logged.
+ */
+size_t trackLength();
+
+/**
+ * @brief Reports, once, that trimming the oldest fixes threw the image-map overlay away.
+ *
+ * trackUpdateImage draws nothing until the overlay is rebuilt, so the caller
+ * must repaint the whole track.
+ *
+ * @return bool True if the overlay was dropped since the last call
+ */
+bool trackImageInvalidated();
+
+/**
+ * @brief Strokes fixes logged since the last call onto the cached image-map overlay.
+ *
+ * @param proj Projection of the image map
+ * @param damage Receives the pixel bounds of the new segments
+ * @return bool False if nothing new was drawn (no cached overlay yet, or no new fixes)
+ */
+bool trackUpdateImage(const mapProjection *proj, cairo_rectangle_int_t *damage);
+
+/**
+ * @brief Paints the clipped part of the track over the single-image map.
+ *
+ * Builds the cached overlay from the simplified track on first use or when the
+ * projection changed.
+ */
+void trackPaintImage(cairo_t *cr, const mapProjection *proj);
+
+/**
+ * @brief Strokes the track over the tile view.
+ *
+ * @param zoom Tile zoom level
+ * @param originX Global pixel X at the view's left edge
+ * @param originY Global pixel Y at the view's top edge
+ */
+void trackPaintTiles(cairo_t *cr, int zoom, double originX, double originY);
+
+/**
+ * @brief Frees the track log, its simplified levels and the cached overlay.
+ */
+void trackShutdown();
+
+#endif
@@ -0,0 +1,425 @@
+/**
+ * @file        transport.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       SPI and simulated receiver transports for UBX traffic.
+ *
+ * @details     Implements the byte-level link declared in transport.h. The SPI transport is
+ *              a thin wrapper around the bcm2835 library. The simulated transport behaves
+ *              like a ZOE-M8Q on SPI: it returns 0xFF while idle, parses UBX commands clocked
+ *              in on MOSI, answers CFG polls, ACKs CFG writes, and emits NAV-PVT epochs on a
+ *              timerfd so the application can be exercised without hardware.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "transport.h"
+#include "gps_setup.h"
+#include "perf_stats.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include <bcm2835.h>
+
+#define SPI_BASE_CLOCK_SPEED 500000000
+#define SPI_BAUD_RATE 115200
+
+// Simulated receiver parameters
+#define SIM_QUEUE_SIZE      4096
+#define SIM_MAX_PAYLOAD     256
+#define SIM_DEFAULT_RATE_MS 1000
+#define SIM_ORIGIN_LAT      40.0150    // route centre, degrees
+#define SIM_ORIGIN_LON      -105.2705  // route centre, degrees
+#define SIM_ROUTE_RADIUS_M  400.0
+#define SIM_SPEED_MPS       13.4       // ~30 mph
+#define METERS_PER_DEG_LAT  111320.0
+
+static transportType activeType = TRANSPORT_SPI;
+
+//////////////// SIMULATED RECEIVER //////////////////
+
+// Receiver -> host byte queue (what the host reads on MISO)
+static uint8_t simQueue[SIM_QUEUE_SIZE];
+static uint32_t simHead = 0;
+static uint32_t simTail = 0;
+
+// Host -> receiver command parser (what the host writes on MOSI)
+static uint8_t simCmd[SIM_MAX_PAYLOAD + 6];
+static uint16_t simCmdPos = 0;
+static uint16_t simCmdLen = 0;
+
+static int simTimerFd = -1;
+static bool simNavPVTEnabled = false;
+static uint16_t simMeasRateMs = SIM_DEFAULT_RATE_MS;
+static uint16_t simNavRate = 1;
+static uint32_t simEpoch = 0;
+
+// Scheduled fault window (CLOCK_MONOTONIC microseconds)
+static simFault simFaultKind = SIM_FAULT_NONE;
+static int64_t simFaultStartUs = 0;
+static int64_t simFaultEndUs = 0;
+static bool simFaultAnnounced = false;
+static const char *simFaultNames[] = {"none", "silent", "garbage", "reset"};
+
+/**
+ * @brief Appends bytes to the receiver output queue, dropping them if it is full.
+ */
+static void simEnqueue(const uint8_t *bytes, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    uint32_t next = (simTail + 1) % SIM_QUEUE_SIZE;
+    if (next == simHead) return;
+    simQueue[simTail] = bytes[i];
+    simTail = next;
+  }
+}
+
+/**
+ * @brief Frames a payload as a UBX message and queues it for the host.
+ */
+static void simEnqueueFrame(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+  uint8_t frame[SIM_MAX_PAYLOAD + 8];
+  frame[0] = 0xB5;
+  frame[1] = 0x62;
+  frame[2] = cls;
+  frame[3] = id;
+  frame[4] = len & 0xFF;
+  frame[5] = len >> 8;
+  memcpy(&frame[6], payload, len);
+  calculateUBXChecksum(&frame[2], len + 4, &frame[6 + len], &frame[7 + len]);
+  simEnqueue(frame, len + 8);
+}
+
+/**
+ * @brief Navigation solution period: measurement period times measurements per solution.
+ */
+static uint32_t simEpochMs() {
+  return (uint32_t)simMeasRateMs * simNavRate;
+}
+
+/**
+ * @brief Re-arms the epoch timer for the current measurement and navigation rate.
+ */
+static void simArmTimer() {
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = simEpochMs() / 1000;
+  spec.it_interval.tv_nsec = (simEpochMs() % 1000) * 1000000L;
+  spec.it_value = spec.it_interval;
+  timerfd_settime(simTimerFd, 0, &spec, NULL);
+}
+
+/**
+ * @brief Queues one NAV-PVT epoch on a circular route around the simulation origin.
+ */
+static void simEmitNavPVT() {
+  navpvt_data pvt;
+  memset(&pvt, 0, sizeof(pvt));
+
+  struct timespec now;
+  struct tm utc;
+  clock_gettime(CLOCK_REALTIME, &now);
+  gmtime_r(&now.tv_sec, &utc);
+
+  double omega = SIM_SPEED_MPS / SIM_ROUTE_RADIUS_M;
+  double theta = omega * simEpoch * (simEpochMs() / 1000.0);
+  double north = SIM_ROUTE_RADIUS_M * cos(theta);
+  double east = SIM_ROUTE_RADIUS_M * sin(theta);
+  double velN = -SIM_SPEED_MPS * sin(theta);
+  double velE = SIM_SPEED_MPS * cos(theta);
+  double heading = atan2(velE, velN) * 180.0 / M_PI;
+  if (heading < 0) heading += 360.0;
+
+  double lat = SIM_ORIGIN_LAT + north / METERS_PER_DEG_LAT;
+  double lon = SIM_ORIGIN_LON + east / (METERS_PER_DEG_LAT * cos(SIM_ORIGIN_LAT * M_PI / 180.0));
+
+  pvt.iTOW = (uint32_t)((now.tv_sec % 604800) * 1000 + now.tv_nsec / 1000000);
+  pvt.year = utc.tm_year + 1900;
+  pvt.month = utc.tm_mon + 1;
+  pvt.day = utc.tm_mday;
+  pvt.hour = utc.tm_hour;
+  pvt.min = utc.tm_min;
+  pvt.sec = utc.tm_sec;
+  pvt.valid.all = 0x07;
+  pvt.nano = (int32_t)now.tv_nsec;
+  pvt.fixType = 3;
+  pvt.flags.bits.gnssFixOK = 1;
+  pvt.numSV = 9;
+  pvt.lat = (int32_t)lrint(lat * 1e7);
+  pvt.lon = (int32_t)lrint(lon * 1e7);
+  pvt.height = 1655000;
+  pvt.hMSL = 1624000;
+  pvt.hAcc = 2500;
+  pvt.vAcc = 3500;
+  pvt.velN = (int32_t)lrint(velN * 1000.0);
+  pvt.velE = (int32_t)lrint(velE * 1000.0);
+  pvt.gSpeed = (int32_t)lrint(SIM_SPEED_MPS * 1000.0);
+  pvt.headMot = (int32_t)lrint(heading * 1e5);
+  pvt.sAcc = 300;
+  pvt.headAcc = 50000;
+  pvt.pDOP = 150;
+
+  simEnqueueFrame(0x01, 0x07, (const uint8_t *)&pvt, sizeof(pvt));
+  simEpoch++;
+}
+
+/**
+ * @brief Reacts to a complete UBX command received from the host.
+ *
+ * CFG polls are answered with the current settings, CFG writes are applied and ACKed.
+ * Out-of-range rates are NACKed.
+ */
+static void simHandleCommand(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+  if (cls != 0x06) return;
+
+  bool accepted = true;
+  // Like the M8, polls are answered with the message followed by an ACK-ACK
+  if (id == 0x08 && len == 0) {
+    uint8_t rate[6] = {simMeasRateMs & 0xFF, simMeasRateMs >> 8, simNavRate & 0xFF, simNavRate >> 8, 0x00, 0x00};
+    simEnqueueFrame(0x06, 0x08, rate, sizeof(rate));
+  } else if (id == 0x01 && len == 2) {
+    uint8_t msg[8] = {payload[0], payload[1], 0, 0, 0, 0, 0, 0};
+    if (payload[0] == 0x01 && payload[1] == 0x07) msg[6] = simNavPVTEnabled ? 1 : 0;
+    simEnqueueFrame(0x06, 0x01, msg, sizeof(msg));
+  } else if (id == 0x08 && len >= 4) {
+    uint16_t measRate = payload[0] | (payload[1] << 8);
+    uint16_t navRate = payload[2] | (payload[3] << 8);
+    if (measRate >= 25 && navRate >= 1) {
+      simMeasRateMs = measRate;
+      simNavRate = navRate;
+      simArmTimer();
+    } else {
+      accepted = false;
+    }
+  } else if (id == 0x01 && len == 8 && payload[0] == 0x01 && payload[1] == 0x07) {
+    simNavPVTEnabled = payload[6] > 0;
+  }
+
+  uint8_t ack[2] = {cls, id};
+  simEnqueueFrame(0x05, accepted ? 0x01 : 0x00, ack, sizeof(ack));
+}
+
+/**
+ * @brief Feeds one MOSI byte into the command parser.
+ */
+static void simFeedCommandByte(uint8_t b) {
+  if (simCmdPos == 0 && b != 0xB5) return;
+  if (simCmdPos == 1 && b != 0x62) {
+    simCmdPos = (b == 0xB5) ? 1 : 0;
+    return;
+  }
+  simCmd[simCmdPos++] = b;
+
+  if (simCmdPos == 6) {
+    simCmdLen = simCmd[4] | (simCmd[5] << 8);
+    if (simCmdLen > SIM_MAX_PAYLOAD) simCmdPos = 0;
+    return;
+  }
+  if (simCmdPos >= 6 && simCmdPos == simCmdLen + 8) {
+    uint8_t ck_a, ck_b;
+    calculateUBXChecksum(&simCmd[2], simCmdLen + 4, &ck_a, &ck_b);
+    if (ck_a == simCmd[simCmdLen + 6] && ck_b == simCmd[simCmdLen + 7]) {
+      simHandleCommand(simCmd[2], simCmd[3], &simCmd[6], simCmdLen);
+    }
+    simCmdPos = 0;
+  }
+}
+
+/**
+ * @brief Emits any epochs that have elapsed since the last transfer.
+ */
+static void simPump() {
+  uint64_t expirations = 0;
+  if (read(simTimerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+  for (uint64_t i = 0; i < expirations; i++) {
+    if (simNavPVTEnabled) simEmitNavPVT();
+  }
+}
+
+static int64_t simNowUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Returns the fault active right now, applying one-shot faults as they trigger.
+ */
+static simFault simActiveFault() {
+  if (simFaultKind == SIM_FAULT_NONE) return SIM_FAULT_NONE;
+  int64_t now = simNowUs();
+  if (now < simFaultStartUs) return SIM_FAULT_NONE;
+
+  if (!simFaultAnnounced) {
+    printf("SIM: injecting fault '%s'\n", simFaultNames[simFaultKind]);
+    simFaultAnnounced = true;
+  }
+  if (simFaultKind == SIM_FAULT_RESET) {
+    simNavPVTEnabled = false;
+    simMeasRateMs = SIM_DEFAULT_RATE_MS;
+    simNavRate = 1;
+    simArmTimer();
+    simHead = simTail;
+    simCmdPos = 0;
+    simFaultKind = SIM_FAULT_NONE;
+    return SIM_FAULT_NONE;
+  }
+  if (now >= simFaultEndUs) {
+    printf("SIM: fault '%s' cleared\n", simFaultNames[simFaultKind]);
+    simFaultKind = SIM_FAULT_NONE;
+    return SIM_FAULT_NONE;
+  }
+  return simFaultKind;
+}
+
+/**
+ * @brief Clocks one byte through the simulated receiver.
+ *
+ * Callers run simPump() once per bus transaction, not per byte.
+ */
+static uint8_t simTransfer(uint8_t value) {
+  uint8_t out = 0xFF;
+  simFault fault = simActiveFault();
+  if (fault == SIM_FAULT_SILENT) {
+    // Unplugged: nothing in, nothing out, epochs are lost
+    simHead = simTail;
+    return 0xFF;
+  }
+  if (simHead != simTail) {
+    out = simQueue[simHead];
+    simHead = (simHead + 1) % SIM_QUEUE_SIZE;
+  }
+  // A command byte can only affect what the receiver clocks out on later transfers
+  simFeedCommandByte(value);
+  if (fault == SIM_FAULT_GARBAGE && (rand() % 64) == 0) {
+    out ^= (uint8_t)(1 << (rand() % 8));
+  }
+  return out;
+}
+
+static int simOpen() {
+  simTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (simTimerFd < 0) {
+    perror("timerfd_create");
+    return -1;
+  }
+  simHead = simTail = 0;
+  simCmdPos = 0;
+  simEpoch = 0;
+  simNavPVTEnabled = false;
+  simMeasRateMs = SIM_DEFAULT_RATE_MS;
+  simNavRate = 1;
+  simArmTimer();
+  printf("Simulated receiver started (origin %.4f, %.4f)\n", SIM_ORIGIN_LAT, SIM_ORIGIN_LON);
+  return 0;
+}
+
+//////////////// SPI //////////////////
+
+static int spiOpen() {
+  uint32_t divider = (SPI_BASE_CLOCK_SPEED / SPI_BAUD_RATE);
+
+  if (!bcm2835_init()) {
+    printf("Error: failed to initialize bcm2835\n");
+    return -1;
+  }
+  printf("BCM2835 Initialized\n");
+
+  bcm2835_spi_begin();
+  printf("SPI STARTED\n");
+  bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
+  printf("Bit order set...\n");
+  bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
+  printf("SPI data mode set\n");
+  bcm2835_spi_setClockDivider(divider);
+  printf("Clock divider set...\n");
+  bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
+  printf("Chip Select pin set\n");
+  bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+  printf("GPIO and SPI Configured\n\n");
+  return 0;
+}
+
+//////////////// TRANSPORT API //////////////////
+
+int transportOpen(transportType type) {
+  activeType = type;
+  return (type == TRANSPORT_SIM) ? simOpen() : spiOpen();
+}
+
+void transportClose() {
+  if (activeType == TRANSPORT_SIM) {
+    if (simTimerFd >= 0) close(simTimerFd);
+    simTimerFd = -1;
+  } else {
+    bcm2835_spi_end();
+    bcm2835_close();
+  }
+}
+
+uint8_t transportTransfer(uint8_t value) {
+  perfNoteBusTransfer(1);
+  if (activeType == TRANSPORT_SIM) {
+    simPump();
+    return simTransfer(value);
+  }
+  return bcm2835_spi_transfer(value);
+}
+
+void transportTransfern(uint8_t *buf, uint32_t len) {
+  perfNoteBusTransfer(len);
+  if (activeType == TRANSPORT_SIM) {
+    simPump();
+    for (uint32_t i = 0; i < len; i++) buf[i] = simTransfer(buf[i]);
+    return;
+  }
+  bcm2835_spi_transfern((char *)buf, len);
+}
+
+void transportTransfernb(const uint8_t *tx, uint8_t *rx, uint32_t len) {
+  perfNoteBusTransfer(len);
+  if (activeType == TRANSPORT_SIM) {
+    simPump();
+    for (uint32_t i = 0; i < len; i++) rx[i] = simTransfer(tx[i]);
+    return;
+  }
+  bcm2835_spi_transfernb((char *)tx, (char *)rx, len);
+}
+
+int transportPollFd() {
+  return (activeType == TRANSPORT_SIM) ? simTimerFd : -1;
+}
+
+const char *transportName() {
+  return (activeType == TRANSPORT_SIM) ? "sim" : "spi";
+}
+
+void transportSimScheduleFault(simFault fault, unsigned int startMs, unsigned int durationMs) {
+  simFaultKind = fault;
+  simFaultStartUs = simNowUs() + (int64_t)startMs * 1000;
+  simFaultEndUs = simFaultStartUs + (int64_t)durationMs * 1000;
+  simFaultAnnounced = false;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file        transport.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Byte transport between the host and the u-blox receiver.
+ *
+ * @details     Abstracts the link used to exchange UBX bytes with the GPS module so the
+ *              protocol code in gps_setup.c does not talk to the BCM2835 SPI driver directly.
+ *              Two transports are provided:
+ *              - `TRANSPORT_SPI`: the real ZOE-M8Q on SPI0 via the bcm2835 library.
+ *              - `TRANSPORT_SIM`: an in-process receiver that answers configuration
+ *                commands and emits a NAV-PVT epoch every second along a test route. Faults
+ *                (silence, corruption, reset) can be injected to measure recovery.
+ *
+ *              Each transport may expose a pollable file descriptor that becomes readable
+ *              when new receiver data may be waiting, which lets a main loop sleep instead
+ *              of spinning on the bus.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Available receiver links.
+ */
+typedef enum transportType {
+  TRANSPORT_SPI,
+  TRANSPORT_SIM
+} transportType;
+
+/**
+ * @brief Faults the simulated receiver can inject, for exercising recovery paths.
+ */
+typedef enum simFault {
+  SIM_FAULT_NONE,
+  SIM_FAULT_SILENT,   // receiver stops responding entirely (unplugged)
+  SIM_FAULT_GARBAGE,  // output bytes are corrupted (noisy or desynced link)
+  SIM_FAULT_RESET     // receiver reboots and loses its volatile configuration
+} simFault;
+
+/**
+ * @brief Opens the selected transport.
+ *
+ * For SPI this initializes the bcm2835 library and configures SPI0.
+ *
+ * @param type Transport to open
+ * @return int 0 on success, -1 on failure
+ */
+int transportOpen(transportType type);
+
+/**
+ * @brief Releases the transport and any hardware it holds.
+ */
+void transportClose();
+
+/**
+ * @brief Exchanges a single byte with the receiver.
+ *
+ * @param value Byte clocked out to the receiver (0xFF when idle)
+ * @return uint8_t Byte clocked in from the receiver
+ */
+uint8_t transportTransfer(uint8_t value);
+
+/**
+ * @brief Exchanges a buffer in place with the receiver.
+ *
+ * @param buf Bytes to send; overwritten with the bytes received
+ * @param len Number of bytes
+ */
+void transportTransfern(uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Full-duplex exchange with separate transmit and receive buffers.
+ *
+ * Every byte clocked in is returned, including those received while command
+ * bytes are going out, so commands can ride along with reads.
+ *
+ * @param tx Bytes to send (0xFF where there is nothing to say)
+ * @param rx Filled with the bytes received
+ * @param len Number of bytes
+ */
+void transportTransfernb(const uint8_t *tx, uint8_t *rx, uint32_t len);
+
+/**
+ * @brief Returns a descriptor that becomes readable when receiver data may be waiting.
+ *
+ * The descriptor is drained by the transport itself on the next transfer.
+ *
+ * @return int File descriptor, or -1 if the transport has no readiness signal
+ */
+int transportPollFd();
+
+/**
+ * @brief Human readable name of the open transport.
+ */
+const char *transportName();
+
+/**
+ * @brief Schedules a fault on the simulated receiver.
+ *
+ * Has no effect on the SPI transport. SIM_FAULT_RESET is instantaneous and
+ * ignores durationMs; the receiver stays unconfigured until commands arrive.
+ *
+ * @param fault Fault to inject
+ * @param startMs Delay from now before the fault begins
+ * @param durationMs How long the fault lasts
+ */
+void transportSimScheduleFault(simFault fault, unsigned int startMs, unsigned int durationMs);
+
+#endif
@@ -0,0 +1,285 @@
+/**
+ * @file        worker_pool.c
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Work-stealing thread pool with completions on the GTK main loop.
+ *
+ * @details     Every worker owns a deque. Submissions are spread round-robin across the
+ *              deques; a worker takes jobs from the back of its own deque and, when that is
+ *              empty, steals from the front of the others before going to sleep. Deques are
+ *              guarded by their own mutex so a steal only contends with one worker. A single
+ *              condition variable wakes sleeping workers when the pending count rises.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#include "worker_pool.h"
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <glib.h>
+
+#define DEQUE_INITIAL_CAPACITY 32
+
+/**
+ * @brief One queued job.
+ */
+typedef struct workItem {
+  workFunc run;
+  workDoneFunc done;
+  void *data;
+} workItem;
+
+/**
+ * @brief Per-worker double-ended job queue (ring buffer that grows on demand).
+ */
+typedef struct workDeque {
+  workItem *items;
+  int capacity;
+  int head;   // index of the oldest job (steal end)
+  int count;
+  pthread_mutex_t lock;
+} workDeque;
+
+static pthread_t workers[WORKER_POOL_MAX_THREADS];
+static workDeque deques[WORKER_POOL_MAX_THREADS];
+static int workerCount = 0;
+static atomic_int nextDeque;
+static atomic_int pendingJobs;
+static atomic_bool poolRunning;
+
+static pthread_mutex_t idleLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idleCond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief A finished job whose completion is waiting for the main loop.
+ */
+typedef struct postedCompletion {
+  workItem item;
+  guint sourceId;
+} postedCompletion;
+
+static GList *posted = NULL;   // postedCompletion *, newest first
+static pthread_mutex_t postedLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void dequePushBack(workDeque *dq, workItem item) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->count == dq->capacity) {
+    int newCapacity = dq->capacity * 2;
+    workItem *grown = (workItem *)malloc(sizeof(workItem) * newCapacity);
+    for (int i = 0; i < dq->count; i++) {
+      grown[i] = dq->items[(dq->head + i) % dq->capacity];
+    }
+    free(dq->items);
+    dq->items = grown;
+    dq->capacity = newCapacity;
+    dq->head = 0;
+  }
+  dq->items[(dq->head + dq->count) % dq->capacity] = item;
+  dq->count++;
+  pthread_mutex_unlock(&dq->lock);
+}
+
+static bool dequePopBack(workDeque *dq, workItem *out) {
+  bool found = false;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->count > 0) {
+    dq->count--;
+    *out = dq->items[(dq->head + dq->count) % dq->capacity];
+    found = true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+static bool dequeStealFront(workDeque *dq, workItem *out) {
+  bool found = false;
+  if (pthread_mutex_trylock(&dq->lock) != 0) return false;
+  if (dq->count > 0) {
+    *out = dq->items[dq->head];
+    dq->head = (dq->head + 1) % dq->capacity;
+    dq->count--;
+    found = true;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+/**
+ * @brief Main-loop trampoline that runs a job's completion on the GTK thread.
+ */
+static gboolean runCompletion(gpointer data) {
+  postedCompletion *completion = (postedCompletion *)data;
+  pthread_mutex_lock(&postedLock);
+  posted = g_list_remove(posted, completion);
+  pthread_mutex_unlock(&postedLock);
+  completion->item.done(completion->item.data);
+  free(completion);
+  return G_SOURCE_REMOVE;
+}
+
+static void finishItem(workItem item) {
+  item.run(item.data);
+  if (item.done) {
+    postedCompletion *completion = (postedCompletion *)malloc(sizeof(postedCompletion));
+    completion->item = item;
+    // Held across the add so runCompletion cannot unlink it before it is listed
+    pthread_mutex_lock(&postedLock);
+    completion->sourceId = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, runCompletion, completion, NULL);
+    posted = g_list_prepend(posted, completion);
+    pthread_mutex_unlock(&postedLock);
+  }
+}
+
+/**
+ * @brief Takes a job from the worker's own deque, or steals one from a sibling.
+ */
+static bool takeItem(int self, workItem *out) {
+  if (dequePopBack(&deques[self], out)) return true;
+  for (int i = 1; i < workerCount; i++) {
+    if (dequeStealFront(&deques[(self + i) % workerCount], out)) return true;
+  }
+  return false;
+}
+
+static void *workerMain(void *arg) {
+  int self = (int)(intptr_t)arg;
+  while (atomic_load(&poolRunning)) {
+    workItem item;
+    if (takeItem(self, &item)) {
+      atomic_fetch_sub(&pendingJobs, 1);
+      finishItem(item);
+      continue;
+    }
+    pthread_mutex_lock(&idleLock);
+    while (atomic_load(&poolRunning) && atomic_load(&pendingJobs) == 0) {
+      pthread_cond_wait(&idleCond, &idleLock);
+    }
+    pthread_mutex_unlock(&idleLock);
+  }
+  return NULL;
+}
+
+int workerPoolStart(int threads) {
+  if (threads <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores > 0 ? (int)cores : 1;
+  }
+  if (threads > WORKER_POOL_MAX_THREADS) threads = WORKER_POOL_MAX_THREADS;
+
+  atomic_store(&poolRunning, true);
+  atomic_store(&pendingJobs, 0);
+  atomic_store(&nextDeque, 0);
+  for (int i = 0; i < threads; i++) {
+    deques[i].items = (workItem *)malloc(sizeof(workItem) * DEQUE_INITIAL_CAPACITY);
+    deques[i].capacity = DEQUE_INITIAL_CAPACITY;
+    deques[i].head = 0;
+    deques[i].count = 0;
+    pthread_mutex_init(&deques[i].lock, NULL);
+  }
+  workerCount = threads;
+
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&workers[i], NULL, workerMain, (void *)(intptr_t)i)) {
+      printf("Error: Failed to create worker thread %d\n", i);
+      workerCount = i;
+      workerPoolStop();
+      // workerPoolStop only releases the deques of threads that started
+      for (int j = i; j < threads; j++) {
+        free(deques[j].items);
+        deques[j].items = NULL;
+        pthread_mutex_destroy(&deques[j].lock);
+      }
+      return -1;
+    }
+  }
+  printf("Worker pool started with %d threads\n", threads);
+  return threads;
+}
+
+void workerPoolSubmit(workFunc run, workDoneFunc done, void *data) {
+  workItem item = {run, done, data};
+  if (workerCount == 0 || !atomic_load(&poolRunning)) {
+    finishItem(item);
+    return;
+  }
+  int target = (int)((unsigned int)atomic_fetch_add(&nextDeque, 1) % (unsigned int)workerCount);
+
+  // Count the job before it becomes visible so pendingJobs never goes negative
+  pthread_mutex_lock(&idleLock);
+  atomic_fetch_add(&pendingJobs, 1);
+  pthread_mutex_unlock(&idleLock);
+
+  dequePushBack(&deques[target], item);
+
+  pthread_mutex_lock(&idleLock);
+  pthread_cond_signal(&idleCond);
+  pthread_mutex_unlock(&idleLock);
+}
+
+int workerPoolPending() {
+  return atomic_load(&pendingJobs);
+}
+
+void workerPoolStop() {
+  pthread_mutex_lock(&idleLock);
+  atomic_store(&poolRunning, false);
+  pthread_cond_broadcast(&idleCond);
+  pthread_mutex_unlock(&idleLock);
+
+  for (int i = 0; i < workerCount; i++) {
+    pthread_join(workers[i], NULL);
+  }
+
+  // The main loop may already have stopped, so run waiting completions here
+  pthread_mutex_lock(&postedLock);
+  GList *finished = g_list_reverse(posted);
+  posted = NULL;
+  pthread_mutex_unlock(&postedLock);
+  for (GList *l = finished; l; l = l->next) {
+    postedCompletion *completion = (postedCompletion *)l->data;
+    g_source_remove(completion->sourceId);
+    completion->item.done(completion->item.data);
+    free(completion);
+  }
+  g_list_free(finished);
+
+  // Jobs no worker picked up still hand their data back through their completion
+  for (int i = 0; i < workerCount; i++) {
+    workItem item;
+    while (dequePopBack(&deques[i], &item)) {
+      if (item.done) item.done(item.data);
+    }
+  }
+  for (int i = 0; i < workerCount; i++) {
+    free(deques[i].items);
+    deques[i].items = NULL;
+    pthread_mutex_destroy(&deques[i].lock);
+  }
+  workerCount = 0;
+  atomic_store(&pendingJobs, 0);
+}
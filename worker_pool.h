@@ -0,0 +1,87 @@
+/**
+ * @file        worker_pool.h
+ * @author      Joshua Anselm
+ * @date        2025-05-04
+ * @version     1.0
+ * @brief       Background worker pool for work that must stay off the GTK thread.
+ *
+ * @details     A small work-stealing pool sized to the number of online cores. Heavy jobs
+ *              such as map image decoding are submitted from the GTK thread, run on a
+ *              worker, and report back through a completion callback that is scheduled on
+ *              the GTK main loop at idle priority, below redraw, so a finishing job never
+ *              delays a frame.
+ *
+ * @license     MIT License
+ *              Copyright (c) 2025 Joshua Anselm
+ *
+ *              Permission is hereby granted, free of charge, to any person obtaining a copy
+ *              of this software and associated documentation files (the "Software"), to deal
+ *              in the Software without restriction, including without limitation the rights
+ *              to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *              copies of the Software, and to permit persons to whom the Software is
+ *              furnished to do so, subject to the following conditions:
+ *
+ *              The above copyright notice and this permission notice shall be included in
+ *              all copies or substantial portions of the Software.
+ *
+ *              THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *              IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *              FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *              AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *              LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *              OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *              SOFTWARE.
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+// Upper bound on worker threads regardless of core count
+#define WORKER_POOL_MAX_THREADS 8
+
+/**
+ * @brief Job body, run on a worker thread.
+ */
+typedef void (*workFunc)(void *data);
+
+/**
+ * @brief Completion callback, run on the GTK main thread after the job body returns.
+ */
+typedef void (*workDoneFunc)(void *data);
+
+/**
+ * @brief Starts the pool.
+ *
+ * @param threads Number of workers, or 0 to use the online core count
+ * @return int Number of workers started, or -1 on failure
+ */
+int workerPoolStart(int threads);
+
+/**
+ * @brief Queues a job.
+ *
+ * Safe to call from any thread. If the pool is not running the job runs inline
+ * and its completion is still deferred to the main loop.
+ *
+ * @param run Job body, run on a worker
+ * @param done Optional completion, run on the GTK thread (may be NULL)
+ * @param data Passed to both callbacks
+ */
+void workerPoolSubmit(workFunc run, workDoneFunc done, void *data);
+
+/**
+ * @brief Number of jobs queued but not yet picked up by a worker.
+ */
+int workerPoolPending();
+
+/**
+ * @brief Stops all workers after they finish the job they are running.
+ *
+ * Must be called on the GTK thread. Completions still waiting for the main
+ * loop are run here, and jobs still queued are not run but have their
+ * completion called, so every job's data is handed back to its owner.
+ * Completions must therefore cope with a job whose body never ran.
+ */
+void workerPoolStop();
+
+#endif